@@ -0,0 +1,124 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <aischeduler.h>
+#include <objects/ai.h>
+#include <objects/object.h>
+#include <objects/physics.h>
+#include <ae/peer.h>
+#include <constants.h>
+#include <glm/gtx/norm.hpp>
+#include <chrono>
+
+// Constructor
+_AiScheduler::_AiScheduler() :
+	ThinkCount(0),
+	DeferredCount(0),
+	ThinkTime(0.0),
+	FixedAgentsPerTick(0),
+	Tick(0),
+	Cursor(0) {
+}
+
+// Run the agents that are due this tick until the time budget or fixed agent count runs out
+void _AiScheduler::Update(double FrameTime, const std::vector<const ae::_Peer *> &Peers) {
+	Tick++;
+	ThinkCount = 0;
+	DeferredCount = 0;
+
+	// Get player positions for level of detail
+	PlayerPositions.clear();
+	for(auto &Peer : Peers) {
+		if(Peer->Object && Peer->Object->Physics)
+			PlayerPositions.push_back(glm::vec2(Peer->Object->Physics->Position));
+	}
+
+	// Resume where the last tick stopped
+	auto StartTime = std::chrono::steady_clock::now();
+	for(size_t i = 0; i < Agents.size(); i++) {
+		if(Cursor >= Agents.size())
+			Cursor = 0;
+
+		_Agent &Agent = Agents[Cursor];
+		if(Agent.NextThink <= Tick) {
+
+			// Always let one agent run so the queue drains, a fixed count keeps hashed and replayed runs deterministic
+			bool OverBudget;
+			if(FixedAgentsPerTick)
+				OverBudget = ThinkCount >= FixedAgentsPerTick;
+			else
+				OverBudget = ThinkCount && std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count() > AI_THINK_BUDGET;
+
+			if(OverBudget) {
+
+				// Count agents left waiting for the next tick
+				for(size_t j = i; j < Agents.size(); j++) {
+					if(Agents[(Cursor + j - i) % Agents.size()].NextThink <= Tick)
+						DeferredCount++;
+				}
+				break;
+			}
+
+			Agent.Ai->Think((Tick - Agent.LastThink) * FrameTime);
+			Agent.LastThink = Tick;
+			Agent.NextThink = Tick + GetThinkPeriod(Agent.Ai);
+			ThinkCount++;
+		}
+
+		Cursor++;
+	}
+
+	ThinkTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+// Add an agent and offset its first think to avoid synchronized spikes
+void _AiScheduler::AddAgent(_Ai *Ai) {
+	uint32_t Offset = Agents.size() % AI_LOD_FAR_PERIOD;
+	Ai->SchedulerIndex = (int)Agents.size();
+	Ai->Stagger((Agents.size() % 100) / 100.0);
+	Agents.push_back(_Agent(Ai, Tick + Offset, Tick));
+}
+
+// Remove an agent by swapping it with the last one
+void _AiScheduler::RemoveAgent(_Ai *Ai) {
+	if(Ai->SchedulerIndex < 0 || Ai->SchedulerIndex >= (int)Agents.size())
+		return;
+
+	size_t Index = Ai->SchedulerIndex;
+	Agents[Index] = Agents.back();
+	Agents[Index].Ai->SchedulerIndex = (int)Index;
+	Agents.pop_back();
+	Ai->SchedulerIndex = -1;
+}
+
+// Get the number of ticks between thinks based on the distance to the nearest player
+uint32_t _AiScheduler::GetThinkPeriod(const _Ai *Ai) const {
+	if(!Ai->Parent->Physics)
+		return AI_LOD_FAR_PERIOD;
+
+	glm::vec2 Position(Ai->Parent->Physics->Position);
+	float MinDistanceSquared = AI_LOD_FAR_DISTANCE * AI_LOD_FAR_DISTANCE;
+	for(auto &PlayerPosition : PlayerPositions)
+		MinDistanceSquared = std::min(MinDistanceSquared, glm::distance2(Position, PlayerPosition));
+
+	if(MinDistanceSquared < AI_LOD_NEAR_DISTANCE * AI_LOD_NEAR_DISTANCE)
+		return 1;
+	else if(MinDistanceSquared < AI_LOD_FAR_DISTANCE * AI_LOD_FAR_DISTANCE)
+		return AI_LOD_MID_PERIOD;
+
+	return AI_LOD_FAR_PERIOD;
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <glm/vec2.hpp>
+#include <vector>
+#include <cstdint>
+
+// Forward Declarations
+class _Ai;
+
+namespace ae {
+	class _Peer;
+}
+
+// Spreads ai think updates across ticks under a time budget, or a fixed agent count when determinism is needed
+class _AiScheduler {
+
+	public:
+
+		_AiScheduler();
+
+		void Update(double FrameTime, const std::vector<const ae::_Peer *> &Peers);
+
+		void AddAgent(_Ai *Ai);
+		void RemoveAgent(_Ai *Ai);
+		size_t GetAgentCount() const { return Agents.size(); }
+
+		// Stats
+		int ThinkCount;
+		int DeferredCount;
+		double ThinkTime;
+
+		// Attributes
+		int FixedAgentsPerTick;
+
+	private:
+
+		struct _Agent {
+			_Agent() { }
+			_Agent(_Ai *Ai, uint32_t NextThink, uint32_t LastThink) : Ai(Ai), NextThink(NextThink), LastThink(LastThink) { }
+
+			_Ai *Ai;
+			uint32_t NextThink;
+			uint32_t LastThink;
+		};
+
+		uint32_t GetThinkPeriod(const _Ai *Ai) const;
+
+		std::vector<_Agent> Agents;
+		std::vector<glm::vec2> PlayerPositions;
+		uint32_t Tick;
+		size_t Cursor;
+
+};
@@ -0,0 +1,85 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <arena.h>
+#include <constants.h>
+#include <algorithm>
+
+// Globals
+thread_local _FrameArena FrameArena(ARENA_SIZE);
+
+// Constructor
+_FrameArena::_FrameArena(size_t Size) :
+	Used(0),
+	PeakUsed(0) {
+
+	AddBlock(Size);
+}
+
+// Destructor
+_FrameArena::~_FrameArena() {
+	for(auto &Block : Blocks)
+		delete[] Block.Data;
+}
+
+// Allocate memory that is valid until the next reset
+void *_FrameArena::Allocate(size_t Size, size_t Alignment) {
+	_Block *Block = &Blocks.back();
+
+	// Align offset
+	size_t Offset = (Block->Offset + Alignment - 1) & ~(Alignment - 1);
+	if(Offset + Size > Block->Size) {
+
+		// Chain a larger block until the next reset
+		AddBlock(std::max(Block->Size * 2, Size + Alignment));
+		Block = &Blocks.back();
+		Offset = (Block->Offset + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	Block->Offset = Offset + Size;
+	Used += Size;
+	if(Used > PeakUsed)
+		PeakUsed = Used;
+
+	return Block->Data + Offset;
+}
+
+// Release all allocations, merging chained blocks into one
+void _FrameArena::Reset() {
+	if(Blocks.size() > 1) {
+		size_t TotalSize = 0;
+		for(auto &Block : Blocks) {
+			TotalSize += Block.Size;
+			delete[] Block.Data;
+		}
+
+		Blocks.clear();
+		AddBlock(TotalSize);
+	}
+
+	Blocks.back().Offset = 0;
+	Used = 0;
+}
+
+// Add a new block of memory
+void _FrameArena::AddBlock(size_t Size) {
+	_Block Block;
+	Block.Data = new uint8_t[Size];
+	Block.Size = Size;
+	Block.Offset = 0;
+	Blocks.push_back(Block);
+}
@@ -0,0 +1,106 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Bump allocator for data that only lives until the end of a tick
+class _FrameArena {
+
+	public:
+
+		_FrameArena(size_t Size);
+		~_FrameArena();
+
+		void *Allocate(size_t Size, size_t Alignment);
+		void Reset();
+
+		size_t GetUsed() const { return Used; }
+		size_t GetPeakUsed() const { return PeakUsed; }
+
+	private:
+
+		struct _Block {
+			uint8_t *Data;
+			size_t Size;
+			size_t Offset;
+		};
+
+		void AddBlock(size_t Size);
+
+		std::vector<_Block> Blocks;
+		size_t Used;
+		size_t PeakUsed;
+
+};
+
+// Growable array of trivially copyable values stored in a frame arena
+template<class T> class _ArenaVector {
+	static_assert(std::is_trivially_copyable<T>::value, "_ArenaVector requires trivially copyable types");
+
+	public:
+
+		_ArenaVector(_FrameArena &Arena, size_t Capacity=16) : Arena(Arena), Data(nullptr), Count(0), Capacity(0) { Reserve(Capacity); }
+
+		void PushBack(const T &Value) {
+			if(Count == Capacity)
+				Reserve(Capacity * 2);
+
+			Data[Count++] = Value;
+		}
+
+		void Reserve(size_t NewCapacity) {
+			if(NewCapacity <= Capacity)
+				return;
+
+			// Old storage is reclaimed when the arena resets
+			T *NewData = (T *)Arena.Allocate(NewCapacity * sizeof(T), alignof(T));
+			if(Count)
+				std::memcpy(NewData, Data, Count * sizeof(T));
+
+			Data = NewData;
+			Capacity = NewCapacity;
+		}
+
+		void Clear() { Count = 0; }
+		size_t Size() const { return Count; }
+		bool IsEmpty() const { return Count == 0; }
+
+		T &operator[](size_t Index) { return Data[Index]; }
+		const T &operator[](size_t Index) const { return Data[Index]; }
+
+		T *begin() { return Data; }
+		T *end() { return Data + Count; }
+		const T *begin() const { return Data; }
+		const T *end() const { return Data + Count; }
+
+	private:
+
+		_FrameArena &Arena;
+		T *Data;
+		size_t Count;
+		size_t Capacity;
+
+};
+
+extern thread_local _FrameArena FrameArena;
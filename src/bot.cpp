@@ -0,0 +1,401 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <bot.h>
+#include <objects/object.h>
+#include <objects/physics.h>
+#include <ae/network.h>
+#include <ae/buffer.h>
+#include <transport.h>
+#include <actiontype.h>
+#include <constants.h>
+#include <packet.h>
+#include <stats.h>
+#include <glm/vec2.hpp>
+#include <algorithm>
+
+// Movement patterns a bot picks from, idle included
+static const uint8_t BotDirections[] = {
+	0,
+	1 << Action::GAME_UP,
+	1 << Action::GAME_DOWN,
+	1 << Action::GAME_LEFT,
+	1 << Action::GAME_RIGHT,
+	(1 << Action::GAME_UP) | (1 << Action::GAME_LEFT),
+	(1 << Action::GAME_UP) | (1 << Action::GAME_RIGHT),
+	(1 << Action::GAME_DOWN) | (1 << Action::GAME_LEFT),
+	(1 << Action::GAME_DOWN) | (1 << Action::GAME_RIGHT),
+};
+
+// Constructor
+_Histogram::_Histogram(double BucketWidth, size_t BucketCount) :
+	Buckets(BucketCount + 1, 0),
+	BucketWidth(BucketWidth),
+	Count(0),
+	Sum(0.0),
+	Max(0.0) {
+}
+
+// Add a sample, values past the last bucket land in an overflow bucket
+void _Histogram::Add(double Value) {
+	size_t Index = std::min((size_t)(std::max(Value, 0.0) / BucketWidth), Buckets.size() - 1);
+	Buckets[Index]++;
+	Count++;
+	Sum += Value;
+	Max = std::max(Max, Value);
+}
+
+// Add samples from a histogram with the same buckets
+void _Histogram::Merge(const _Histogram &Histogram) {
+	for(size_t i = 0; i < Buckets.size() && i < Histogram.Buckets.size(); i++)
+		Buckets[i] += Histogram.Buckets[i];
+
+	Count += Histogram.Count;
+	Sum += Histogram.Sum;
+	Max = std::max(Max, Histogram.Max);
+}
+
+// Remove all samples
+void _Histogram::Clear() {
+	std::fill(Buckets.begin(), Buckets.end(), 0);
+	Count = 0;
+	Sum = 0.0;
+	Max = 0.0;
+}
+
+// Get the upper edge of the bucket holding a percentile
+double _Histogram::GetPercentile(double Percent) const {
+	if(!Count)
+		return 0.0;
+
+	uint64_t Target = (uint64_t)(Count * Percent / 100.0);
+	uint64_t Total = 0;
+	for(size_t i = 0; i < Buckets.size() - 1; i++) {
+		Total += Buckets[i];
+		if(Total > Target)
+			return (i + 1) * BucketWidth;
+	}
+
+	return Max;
+}
+
+// Constructor
+_Bot::_Bot(const _Stats *Stats, const std::string &MapName, double AttackRate, uint32_t Seed) :
+	Latency(BOT_LATENCY_BUCKET, BOT_LATENCY_BUCKETS),
+	Snapshots(0),
+	Network(new _ENetClientTransport()),
+	Connected(false),
+	ReceivedBytes(0),
+	SentBytes(0),
+	Stats(Stats),
+	MapName(MapName),
+	MapID(0),
+	PlayerID(0),
+	HasPlayer(false),
+	TimeSteps(0),
+	LastServerTimeSteps(0),
+	Random(Seed),
+	Time(0.0),
+	AttackRate(AttackRate),
+	AttackTimer(0.0),
+	HoldTicks(0),
+	ActionState(0),
+	Rotation(0.0f) {
+}
+
+// Destructor
+_Bot::~_Bot() {
+}
+
+// Start connecting to a server
+void _Bot::Connect(const std::string &HostAddress, uint16_t Port) {
+	Network->Connect(HostAddress.c_str(), Port);
+}
+
+// Leave the server immediately
+void _Bot::Disconnect() {
+	if(Connected)
+		Network->Disconnect(true);
+}
+
+// Get bytes received since the last call
+size_t _Bot::TakeReceivedBytes() {
+	size_t Bytes = ReceivedBytes;
+	ReceivedBytes = 0;
+
+	return Bytes;
+}
+
+// Get bytes sent since the last call
+size_t _Bot::TakeSentBytes() {
+	size_t Bytes = SentBytes;
+	SentBytes = 0;
+
+	return Bytes;
+}
+
+// Update
+void _Bot::Update(double FrameTime) {
+	Time += FrameTime;
+	Network->Update(FrameTime);
+
+	// Get events
+	ae::_NetworkEvent NetworkEvent;
+	while(Network->GetNetworkEvent(NetworkEvent)) {
+		switch(NetworkEvent.Type) {
+			case ae::_NetworkEvent::CONNECT: {
+				Connected = true;
+
+				ae::_Buffer Buffer;
+				Buffer.Write<char>(Packet::CLIENT_JOIN);
+				Buffer.WriteString(MapName.c_str());
+				SendPacket(Buffer, true);
+			} break;
+			case ae::_NetworkEvent::DISCONNECT:
+				Connected = false;
+				HasPlayer = false;
+				Inputs.clear();
+			break;
+			case ae::_NetworkEvent::PACKET:
+				ReceivedBytes += NetworkEvent.Data->GetCurrentSize();
+				HandlePacket(*NetworkEvent.Data);
+				delete NetworkEvent.Data;
+			break;
+		}
+	}
+
+	if(!Connected || !HasPlayer)
+		return;
+
+	// Play one scripted input per tick like the client
+	UpdateScript();
+	if(Inputs.size() >= BOT_MAX_INPUTS)
+		Inputs.pop_front();
+	Inputs.push_back({ TimeSteps, ActionState, Time });
+	TimeSteps++;
+	SendInputs();
+
+	// Fire at a steady rate
+	if(AttackRate > 0.0) {
+		AttackTimer += FrameTime;
+		while(AttackTimer >= 1.0 / AttackRate) {
+			SendAttack();
+			AttackTimer -= 1.0 / AttackRate;
+		}
+	}
+}
+
+// Hold a random direction and aim for a random number of ticks
+void _Bot::UpdateScript() {
+	if(HoldTicks-- > 0)
+		return;
+
+	std::uniform_int_distribution<int> HoldDistribution(BOT_HOLD_MIN, BOT_HOLD_MAX);
+	std::uniform_int_distribution<size_t> DirectionDistribution(0, sizeof(BotDirections) / sizeof(BotDirections[0]) - 1);
+	std::uniform_real_distribution<float> RotationDistribution(0.0f, 360.0f);
+	HoldTicks = HoldDistribution(Random);
+	ActionState = BotDirections[DirectionDistribution(Random)];
+	Rotation = RotationDistribution(Random);
+}
+
+// Send every unacknowledged input, run length encoded like _Controller::NetworkSerializeHistory
+void _Bot::SendInputs() {
+	ae::_Buffer Buffer(200);
+	Buffer.Write<char>(Packet::CLIENT_INPUT);
+	Buffer.Write<float>(Rotation);
+	Buffer.Write<uint16_t>(Inputs.front().Time);
+
+	// Start key header
+	uint8_t *LastByte = Buffer.Write<uint8_t>(0);
+
+	// Delta compress keys
+	int KeyCount = 0;
+	uint8_t LastKey = Inputs.front().ActionState;
+	for(size_t i = 1; i < Inputs.size(); i++) {
+		uint8_t Key = Inputs[i].ActionState;
+		if(Key != LastKey || KeyCount == 15) {
+
+			// Write key state out - 4 bits for key count, 4 bits for key state
+			*LastByte = (KeyCount << 4) | LastKey;
+
+			// Write new key header
+			LastByte = Buffer.Write<uint8_t>(0);
+			LastKey = Key;
+			KeyCount = 0;
+		}
+		else {
+			KeyCount++;
+		}
+	}
+
+	// Write final key state
+	*LastByte = (KeyCount << 4) | LastKey;
+
+	SendPacket(Buffer, false);
+}
+
+// Send attack command
+void _Bot::SendAttack() {
+	ae::_Buffer Buffer;
+	Buffer.Write<char>(Packet::CLIENT_ATTACK);
+	Buffer.Write<float>(Rotation);
+	SendPacket(Buffer, true);
+}
+
+// Send a packet and count its size
+void _Bot::SendPacket(ae::_Buffer &Buffer, bool Reliable) {
+	SentBytes += Buffer.GetCurrentSize();
+	if(Reliable)
+		Network->SendPacket(Buffer);
+	else
+		Network->SendPacket(Buffer, ae::_Network::UNSEQUENCED, 1);
+}
+
+// Handle packet from server
+void _Bot::HandlePacket(ae::_Buffer &Data) {
+	char PacketType = Data.Read<char>();
+
+	switch(PacketType) {
+		case Packet::STRING_TABLE:
+			StringTable.Unserialize(Data);
+		break;
+		case Packet::MAP_INFO:
+			MapID = Data.Read<ae::NetworkIDType>();
+			Objects.clear();
+			HasPlayer = false;
+		break;
+		case Packet::OBJECT_LIST:
+			HandleObjectList(Data);
+		break;
+		case Packet::OBJECT_CREATE:
+			HandleObjectCreate(Data);
+		break;
+		case Packet::OBJECT_DELETE:
+			HandleObjectDelete(Data);
+		break;
+		case Packet::OBJECT_UPDATES:
+			HandleObjectUpdates(Data);
+		break;
+	}
+}
+
+// Handle a chunk of the object list, only the update layout of each object is kept
+void _Bot::HandleObjectList(ae::_Buffer &Data) {
+
+	// Read header
+	uint16_t ListTimeSteps = Data.Read<uint16_t>();
+	PlayerID = Data.Read<ae::NetworkIDType>();
+	bool FirstChunk = Data.Read<char>();
+	ae::NetworkIDType ObjectCount = Data.Read<ae::NetworkIDType>();
+
+	// Start over on the first chunk
+	if(FirstChunk) {
+		Objects.clear();
+		Inputs.clear();
+		TimeSteps = ListTimeSteps;
+		LastServerTimeSteps = TimeSteps - 1;
+	}
+
+	// Read objects
+	for(ae::NetworkIDType i = 0; i < ObjectCount; i++) {
+		std::string Identifier = _StringTable::ReadString(&StringTable, Data);
+		ae::NetworkIDType NetworkID = Data.Read<ae::NetworkIDType>();
+		ReadObject(Data, Identifier, NetworkID);
+
+		if(NetworkID == PlayerID)
+			HasPlayer = true;
+	}
+}
+
+// Handle a create packet
+void _Bot::HandleObjectCreate(ae::_Buffer &Data) {
+	ae::NetworkIDType ObjectMapID = Data.Read<ae::NetworkIDType>();
+	if(ObjectMapID != MapID)
+		return;
+
+	std::string Identifier = _StringTable::ReadString(&StringTable, Data);
+	ae::NetworkIDType NetworkID = Data.Read<ae::NetworkIDType>();
+	ReadObject(Data, Identifier, NetworkID);
+}
+
+// Handle a delete packet
+void _Bot::HandleObjectDelete(ae::_Buffer &Data) {
+	ae::NetworkIDType ObjectMapID = Data.Read<ae::NetworkIDType>();
+	if(ObjectMapID != MapID)
+		return;
+
+	Objects.erase(Data.Read<ae::NetworkIDType>());
+}
+
+// Read the snapshot, acknowledging inputs from the player's controller state
+void _Bot::HandleObjectUpdates(ae::_Buffer &Data) {
+	ae::NetworkIDType UpdateMapID = Data.Read<ae::NetworkIDType>();
+	if(UpdateMapID != MapID)
+		return;
+
+	// Discard out of order packets
+	uint16_t ServerTimeSteps = Data.Read<uint16_t>();
+	if(!ae::_Network::MoreRecentAck(LastServerTimeSteps, ServerTimeSteps, uint16_t(-1)))
+		return;
+
+	LastServerTimeSteps = ServerTimeSteps;
+	Snapshots++;
+
+	ae::NetworkIDType ObjectCount = Data.Read<ae::NetworkIDType>();
+	for(ae::NetworkIDType i = 0; i < ObjectCount; i++) {
+		ae::NetworkIDType NetworkID = Data.Read<ae::NetworkIDType>();
+
+		// The rest of the packet can't be parsed without the layout
+		auto Iterator = Objects.find(NetworkID);
+		if(Iterator == Objects.end())
+			return;
+
+		if(Iterator->second.HasController) {
+			uint16_t LastInputTime = Data.Read<uint16_t>();
+			if(NetworkID == PlayerID)
+				AcknowledgeInputs(LastInputTime);
+		}
+
+		if(Iterator->second.HasPhysics) {
+			Data.Read<glm::vec2>();
+			Data.Read<float>();
+		}
+	}
+}
+
+// Unserialize into a reusable object per identifier to find how its updates are laid out
+void _Bot::ReadObject(ae::_Buffer &Data, const std::string &Identifier, ae::NetworkIDType NetworkID) {
+	std::unique_ptr<_Object> &Template = Templates[Identifier];
+	if(!Template) {
+		Template.reset(new _Object());
+		Stats->CreateObject(Template.get(), Identifier, true);
+	}
+
+	Template->NetworkUnserialize(Data);
+
+	_ObjectLayout &Layout = Objects[NetworkID];
+	Layout.HasController = Template->HasComponent("controller");
+	Layout.HasPhysics = Template->Physics != nullptr;
+}
+
+// Drop inputs the server has run and record how long each took
+void _Bot::AcknowledgeInputs(uint16_t LastInputTime) {
+	while(!Inputs.empty() && !ae::_Network::MoreRecentAck(LastInputTime, Inputs.front().Time, uint16_t(-1))) {
+		Latency.Add((Time - Inputs.front().SentTime) * 1000.0);
+		Inputs.pop_front();
+	}
+}
@@ -0,0 +1,143 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <stringtable.h>
+#include <ae/type.h>
+#include <unordered_map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+// Forward Declarations
+class _ClientTransport;
+class _Object;
+class _Stats;
+
+namespace ae {
+	class _Buffer;
+}
+
+// Fixed width histogram for latency and bandwidth samples
+class _Histogram {
+
+	public:
+
+		_Histogram(double BucketWidth, size_t BucketCount);
+
+		void Add(double Value);
+		void Merge(const _Histogram &Histogram);
+		void Clear();
+
+		double GetPercentile(double Percent) const;
+		double GetMean() const { return Count ? Sum / Count : 0.0; }
+		double GetMax() const { return Max; }
+		uint64_t GetCount() const { return Count; }
+
+	private:
+
+		std::vector<uint64_t> Buckets;
+		double BucketWidth;
+		uint64_t Count;
+		double Sum;
+		double Max;
+
+};
+
+// Headless client that joins a map and plays scripted input over the real protocol
+class _Bot {
+
+	public:
+
+		_Bot(const _Stats *Stats, const std::string &MapName, double AttackRate, uint32_t Seed);
+		~_Bot();
+
+		void Connect(const std::string &HostAddress, uint16_t Port);
+		void Disconnect();
+		void Update(double FrameTime);
+
+		bool IsConnected() const { return Connected; }
+		bool HasJoined() const { return HasPlayer; }
+		size_t TakeReceivedBytes();
+		size_t TakeSentBytes();
+
+		// Milliseconds from sending an input until a snapshot acknowledges it
+		_Histogram Latency;
+		uint32_t Snapshots;
+
+	private:
+
+		// Sent input waiting for acknowledgement
+		struct _Input {
+			uint16_t Time;
+			uint8_t ActionState;
+			double SentTime;
+		};
+
+		// What each object writes in an update
+		struct _ObjectLayout {
+			bool HasController;
+			bool HasPhysics;
+		};
+
+		void HandlePacket(ae::_Buffer &Data);
+		void HandleObjectList(ae::_Buffer &Data);
+		void HandleObjectCreate(ae::_Buffer &Data);
+		void HandleObjectDelete(ae::_Buffer &Data);
+		void HandleObjectUpdates(ae::_Buffer &Data);
+		void ReadObject(ae::_Buffer &Data, const std::string &Identifier, ae::NetworkIDType NetworkID);
+		void AcknowledgeInputs(uint16_t LastInputTime);
+
+		void UpdateScript();
+		void SendInputs();
+		void SendAttack();
+		void SendPacket(ae::_Buffer &Buffer, bool Reliable);
+
+		// Network
+		std::unique_ptr<_ClientTransport> Network;
+		_StringTable StringTable;
+		bool Connected;
+		size_t ReceivedBytes;
+		size_t SentBytes;
+
+		// World
+		const _Stats *Stats;
+		std::unordered_map<std::string, std::unique_ptr<_Object>> Templates;
+		std::unordered_map<ae::NetworkIDType, _ObjectLayout> Objects;
+		std::string MapName;
+		ae::NetworkIDType MapID;
+		ae::NetworkIDType PlayerID;
+		bool HasPlayer;
+		uint16_t TimeSteps;
+		uint16_t LastServerTimeSteps;
+
+		// Script
+		std::deque<_Input> Inputs;
+		std::mt19937 Random;
+		double Time;
+		double AttackRate;
+		double AttackTimer;
+		int HoldTicks;
+		uint8_t ActionState;
+		float Rotation;
+
+};
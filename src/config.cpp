@@ -95,6 +95,7 @@ void _Config::SetDefaults() {
 	FakeLag = 0.0;
 	NetworkRate = DEFAULT_NETWORKRATE;
 	NetworkPort = DEFAULT_NETWORKPORT;
+	LocalLoopback = 1;
 	ShowTutorial = 1;
 	DesignToolURL = "http://localhost:8000";
 	LastHost = "127.0.0.1";
@@ -189,6 +190,7 @@ void _Config::Load() {
 	GetValue("max_clients", MaxClients);
 	GetValue("network_rate", NetworkRate);
 	GetValue("network_port", NetworkPort);
+	GetValue("local_loopback", LocalLoopback);
 	GetValue("browser_command", BrowserCommand);
 	GetValue("designtool_url", DesignToolURL);
 	GetValue("showtutorial", ShowTutorial);
@@ -199,6 +201,11 @@ void _Config::Load() {
 	if(NetworkRate < 0.01)
 		NetworkRate = 0.01;
 
+	if(MaxClients < 1)
+		MaxClients = 1;
+	else if(MaxClients > NETWORK_MAX_PEERS)
+		MaxClients = NETWORK_MAX_PEERS;
+
 	// Clear bindings
 	for(int i = 0; i < ae::_Input::INPUT_COUNT; i++)
 		ae::Actions.ClearMappings(i);
@@ -248,6 +255,7 @@ void _Config::Save() {
 	File << "max_clients=" << MaxClients << std::endl;
 	File << "network_rate=" << NetworkRate << std::endl;
 	File << "network_port=" << NetworkPort << std::endl;
+	File << "local_loopback=" << LocalLoopback << std::endl;
 	File << "browser_command=" << BrowserCommand << std::endl;
 	File << "designtool_url=" << DesignToolURL << std::endl;
 	File << "showtutorial=" << ShowTutorial << std::endl;
@@ -62,6 +62,7 @@ class _Config {
 		double FakeLag;
 		double NetworkRate;
 		uint16_t NetworkPort;
+		int LocalLoopback;
 
 		// Editor
 		std::string BrowserCommand;
@@ -46,6 +46,7 @@ const  double       GAME_FPS                       =  100.0;
 const  double       GAME_TIMESTEP                  =  1.0/GAME_FPS;
 const  double       DEFAULT_AUTOSAVE_PERIOD        =  60.0;
 const  double       MATH_PI                        =  3.14159265358979323846;
+const  size_t       ARENA_SIZE                     =  256 * 1024;
 //     Camera
 const  float        CAMERA_DISTANCE                =  6.5f;
 const  float        CAMERA_DIVISOR                 =  15.0f;
@@ -55,10 +56,49 @@ const  float        CAMERA_NEAR                    =  0.1f;
 const  float        CAMERA_FAR                     =  100.0f;
 //     Map
 const  int          MAP_FILEVERSION                =  6;
+const  int          OBJECT_SLEEP_TICKS             =  50;
 const  std::string  MAP_DEFAULT_TILESET            =  "textures/tiles/atlas0.png";
 const  float        MAP_WALLZ                      =  2.0f;
 const  glm::ivec2   MAP_SIZE                       =  glm::ivec2(100,100);
 const  float        MAP_BLOCK_ADJUST               =  0.001f;
+const  int          MAP_FLOOR_CHUNK_SIZE           =  32;
+//     Physics
+const  float        PHYSICS_CCD_THRESHOLD          =  0.5f;
+const  float        PHYSICS_CCD_SKIN               =  0.001f;
+const  int          PHYSICS_CCD_ITERATIONS         =  3;
+const  size_t       PHYSICS_PARALLEL_MIN_BODIES    =  256;
+//     Scripting
+const  int          SCRIPT_HOOK_INTERVAL           =  1000;
+const  int          SCRIPT_INSTRUCTION_BUDGET      =  1000000;
+//     Network
+const  size_t       NETWORK_MAX_PEERS              =  4095;
+const  size_t       NETWORK_OBJECT_LIST_CHUNK      =  64;
+const  float        NETWORK_PREDICTION_TOLERANCE   =  0.001f;
+const  int          NETWORK_INTERP_DELAY           =  10;
+const  int          NETWORK_INTERP_MIN_DELAY       =  2;
+const  int          NETWORK_INTERP_MAX_DELAY       =  50;
+const  double       NETWORK_INTERP_SMOOTHING       =  0.1;
+const  double       NETWORK_INTERP_JITTER_SCALE    =  2.0;
+//     Bot
+const  double       BOT_ATTACK_RATE                =  1.0;
+const  double       BOT_REPORT_PERIOD              =  5.0;
+const  int          BOT_CONNECTS_PER_UPDATE        =  4;
+const  int          BOT_HOLD_MIN                   =  30;
+const  int          BOT_HOLD_MAX                   =  180;
+const  size_t       BOT_MAX_INPUTS                 =  120;
+const  double       BOT_LATENCY_BUCKET             =  1.0;
+const  size_t       BOT_LATENCY_BUCKETS            =  1000;
+const  double       BOT_BANDWIDTH_BUCKET           =  0.25;
+const  size_t       BOT_BANDWIDTH_BUCKETS          =  400;
+//     Ai
+const  int          AI_FLOWFIELD_RADIUS            =  32;
+const  int          AI_FLOWFIELD_IDLE_TICKS        =  100;
+const  double       AI_THINK_BUDGET                =  0.002;
+const  int          AI_FIXED_AGENTS_PER_TICK       =  64;
+const  float        AI_LOD_NEAR_DISTANCE           =  15.0f;
+const  float        AI_LOD_FAR_DISTANCE            =  40.0f;
+const  uint32_t     AI_LOD_MID_PERIOD              =  4;
+const  uint32_t     AI_LOD_FAR_PERIOD              =  16;
 //     Editor
 const  std::string  EDITOR_TESTLEVEL               =  "test.map";
 const  int          EDITOR_DEFAULT_GRIDMODE        =  5;
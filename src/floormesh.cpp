@@ -0,0 +1,162 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <floormesh.h>
+#include <grid.h>
+#include <constants.h>
+#include <ae/graphics.h>
+#include <glm/common.hpp>
+#include <glm/vec3.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <cmath>
+
+// Constructor, takes the texture coordinates for each tile index
+_FloorMesh::_FloorMesh(const _Grid *Grid, const std::vector<glm::vec4> &TextureCoords) :
+	Grid(Grid),
+	TextureCoords(TextureCoords),
+	ChunkCount((Grid->Size + MAP_FLOOR_CHUNK_SIZE - 1) / MAP_FLOOR_CHUNK_SIZE),
+	BuildCount(0),
+	ElementBufferID(0) {
+
+	// Set up chunk bounds, edge chunks may be smaller
+	Chunks.resize(ChunkCount.x * ChunkCount.y);
+	for(int j = 0; j < ChunkCount.y; j++) {
+		for(int i = 0; i < ChunkCount.x; i++) {
+			_Chunk &Chunk = Chunks[j * ChunkCount.x + i];
+			Chunk.Start = glm::ivec2(i, j) * MAP_FLOOR_CHUNK_SIZE;
+			Chunk.Size = glm::min(Grid->Size - Chunk.Start, glm::ivec2(MAP_FLOOR_CHUNK_SIZE));
+			Chunk.VertexBufferID = 0;
+			Chunk.Dirty = true;
+			Chunk.Upload = false;
+		}
+	}
+}
+
+// Destructor
+_FloorMesh::~_FloorMesh() {
+	for(auto &Chunk : Chunks) {
+		if(Chunk.VertexBufferID)
+			glDeleteBuffers(1, &Chunk.VertexBufferID);
+	}
+
+	if(ElementBufferID)
+		glDeleteBuffers(1, &ElementBufferID);
+}
+
+// Mark the chunk containing a tile for rebuilding
+void _FloorMesh::Invalidate(const glm::ivec2 &Coord) {
+	if(Coord.x < 0 || Coord.y < 0 || Coord.x >= Grid->Size.x || Coord.y >= Grid->Size.y)
+		return;
+
+	glm::ivec2 ChunkCoord = Coord / MAP_FLOOR_CHUNK_SIZE;
+	Chunks[ChunkCoord.y * ChunkCount.x + ChunkCoord.x].Dirty = true;
+}
+
+// Mark all chunks for rebuilding
+void _FloorMesh::InvalidateAll() {
+	for(auto &Chunk : Chunks)
+		Chunk.Dirty = true;
+}
+
+// Pick the chunks overlapping an AABB
+void _FloorMesh::SelectChunks(const glm::vec4 &Bounds) {
+	VisibleChunks.clear();
+
+	glm::ivec2 Start(std::floor(Bounds[0]), std::floor(Bounds[1]));
+	glm::ivec2 End(std::ceil(Bounds[2]) - 1, std::ceil(Bounds[3]) - 1);
+	Start = glm::max(Start, glm::ivec2(0));
+	End = glm::min(End, Grid->Size - 1);
+	if(End.x < Start.x || End.y < Start.y)
+		return;
+
+	Start /= MAP_FLOOR_CHUNK_SIZE;
+	End /= MAP_FLOOR_CHUNK_SIZE;
+	for(int j = Start.y; j <= End.y; j++) {
+		for(int i = Start.x; i <= End.x; i++)
+			VisibleChunks.push_back(j * ChunkCount.x + i);
+	}
+}
+
+// Rebuild vertices for visible chunks that have changed
+void _FloorMesh::BuildChunks() {
+	for(auto Index : VisibleChunks) {
+		_Chunk &Chunk = Chunks[Index];
+		if(Chunk.Dirty)
+			BuildChunk(Chunk);
+	}
+}
+
+// Upload rebuilt chunks and draw the visible ones
+void _FloorMesh::Render() {
+	if(VisibleChunks.empty())
+		return;
+
+	// Every chunk uses the same quad layout, so share one element buffer
+	if(!ElementBufferID) {
+		std::vector<glm::u32vec3> Faces;
+		uint32_t TileCount = MAP_FLOOR_CHUNK_SIZE * MAP_FLOOR_CHUNK_SIZE;
+		Faces.reserve(2 * TileCount);
+		for(uint32_t VertexIndex = 0; VertexIndex < 4 * TileCount; VertexIndex += 4) {
+			Faces.push_back({ VertexIndex + 2, VertexIndex + 1, VertexIndex + 0 });
+			Faces.push_back({ VertexIndex + 2, VertexIndex + 3, VertexIndex + 1 });
+		}
+
+		glGenBuffers(1, &ElementBufferID);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ElementBufferID);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(glm::u32vec3) * Faces.size(), Faces.data(), GL_STATIC_DRAW);
+	}
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ElementBufferID);
+	for(auto Index : VisibleChunks) {
+		_Chunk &Chunk = Chunks[Index];
+
+		// Upload vertices once after each rebuild
+		if(!Chunk.VertexBufferID)
+			glGenBuffers(1, &Chunk.VertexBufferID);
+		glBindBuffer(GL_ARRAY_BUFFER, Chunk.VertexBufferID);
+		if(Chunk.Upload) {
+			glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec4) * Chunk.Vertices.size(), Chunk.Vertices.data(), GL_STATIC_DRAW);
+			Chunk.Upload = false;
+		}
+
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)sizeof(glm::vec2));
+		glDrawElements(GL_TRIANGLES, Chunk.Size.x * Chunk.Size.y * 6, GL_UNSIGNED_INT, 0);
+	}
+}
+
+// Build four vertices per tile in a chunk
+void _FloorMesh::BuildChunk(_Chunk &Chunk) {
+	Chunk.Vertices.clear();
+	Chunk.Vertices.reserve(4 * Chunk.Size.x * Chunk.Size.y);
+	for(int j = Chunk.Start.y; j < Chunk.Start.y + Chunk.Size.y; j++) {
+		for(int i = Chunk.Start.x; i < Chunk.Start.x + Chunk.Size.x; i++) {
+			uint32_t TextureIndex = Grid->Tiles[i][j].TextureIndex;
+			glm::vec4 Coords = TextureIndex < TextureCoords.size() ? TextureCoords[TextureIndex] : glm::vec4(0.0f);
+			Chunk.Vertices.push_back({ i + 0.0f, j + 0.0f, Coords[0], Coords[1] });
+			Chunk.Vertices.push_back({ i + 1.0f, j + 0.0f, Coords[2], Coords[1] });
+			Chunk.Vertices.push_back({ i + 0.0f, j + 1.0f, Coords[0], Coords[3] });
+			Chunk.Vertices.push_back({ i + 1.0f, j + 1.0f, Coords[2], Coords[3] });
+		}
+	}
+
+	Chunk.Dirty = false;
+	Chunk.Upload = true;
+	BuildCount++;
+}
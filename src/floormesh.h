@@ -0,0 +1,75 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+#include <cstdint>
+
+// Forward Declarations
+class _Grid;
+
+// Floor tiles split into fixed size chunks whose vertices are only rebuilt when a tile in them changes
+class _FloorMesh {
+
+	public:
+
+		_FloorMesh(const _Grid *Grid, const std::vector<glm::vec4> &TextureCoords);
+		~_FloorMesh();
+
+		void Invalidate(const glm::ivec2 &Coord);
+		void InvalidateAll();
+
+		// Selecting and building only touch the cpu, rendering uploads and draws
+		void SelectChunks(const glm::vec4 &Bounds);
+		void BuildChunks();
+		void Render();
+
+		// Stats
+		size_t GetChunkCount() const { return Chunks.size(); }
+		size_t GetVisibleChunkCount() const { return VisibleChunks.size(); }
+		int GetBuildCount() const { return BuildCount; }
+
+	private:
+
+		struct _Chunk {
+			glm::ivec2 Start;
+			glm::ivec2 Size;
+			std::vector<glm::vec4> Vertices;
+			uint32_t VertexBufferID;
+			bool Dirty;
+			bool Upload;
+		};
+
+		void BuildChunk(_Chunk &Chunk);
+
+		const _Grid *Grid;
+		std::vector<glm::vec4> TextureCoords;
+
+		// Chunks
+		glm::ivec2 ChunkCount;
+		std::vector<_Chunk> Chunks;
+		std::vector<uint32_t> VisibleChunks;
+		int BuildCount;
+
+		// Rendering
+		uint32_t ElementBufferID;
+
+};
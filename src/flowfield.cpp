@@ -0,0 +1,131 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <flowfield.h>
+#include <grid.h>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <functional>
+
+// Neighbor offsets, orthogonal first, opposite directions differ by the lowest bit
+static const glm::ivec2 FlowOffsets[8] = {
+	{  1,  0 },
+	{ -1,  0 },
+	{  0,  1 },
+	{  0, -1 },
+	{  1,  1 },
+	{ -1, -1 },
+	{ -1,  1 },
+	{  1, -1 },
+};
+
+// Step costs for orthogonal and diagonal moves
+static const uint32_t FLOW_COST_STRAIGHT = 10;
+static const uint32_t FLOW_COST_DIAGONAL = 14;
+static const uint32_t FLOW_COST_NONE = (uint32_t)-1;
+static const uint8_t FLOW_DIRECTION_NONE = 0xFF;
+
+// Constructor
+_FlowField::_FlowField(const _Grid *Grid) :
+	Goal(-1, -1),
+	IdleTicks(0),
+	Grid(Grid) {
+
+	Costs.resize(Grid->Size.x * Grid->Size.y, FLOW_COST_NONE);
+	Directions.resize(Grid->Size.x * Grid->Size.y, FLOW_DIRECTION_NONE);
+}
+
+// Run dijkstra outward from the goal tile and store the best direction for each tile
+void _FlowField::Build(const glm::ivec2 &Goal, int Radius) {
+	this->Goal = Grid->GetValidCoord(Goal);
+
+	// Reset cells reached by the previous search
+	for(auto Index : Touched) {
+		Costs[Index] = FLOW_COST_NONE;
+		Directions[Index] = FLOW_DIRECTION_NONE;
+	}
+	Touched.clear();
+
+	// Seed goal
+	uint32_t MaxCost = Radius * FLOW_COST_STRAIGHT;
+	uint32_t GoalIndex = this->Goal.x + this->Goal.y * Grid->Size.x;
+	Costs[GoalIndex] = 0;
+	Touched.push_back(GoalIndex);
+	Open.clear();
+	Open.push_back(_Node(0, GoalIndex));
+
+	// Expand nodes
+	while(!Open.empty()) {
+		std::pop_heap(Open.begin(), Open.end(), std::greater<_Node>());
+		_Node Node = Open.back();
+		Open.pop_back();
+
+		// Skip stale entries
+		if(Node.Cost != Costs[Node.Index])
+			continue;
+
+		glm::ivec2 Coord(Node.Index % Grid->Size.x, Node.Index / Grid->Size.x);
+		for(int i = 0; i < 8; i++) {
+			glm::ivec2 Neighbor = Coord + FlowOffsets[i];
+			if(Neighbor.x < 0 || Neighbor.y < 0 || Neighbor.x >= Grid->Size.x || Neighbor.y >= Grid->Size.y)
+				continue;
+
+			if(!Grid->IsWalkable(Neighbor.x, Neighbor.y))
+				continue;
+
+			// Don't cut corners around blocked tiles
+			bool Diagonal = i >= 4;
+			if(Diagonal && (!Grid->IsWalkable(Neighbor.x, Coord.y) || !Grid->IsWalkable(Coord.x, Neighbor.y)))
+				continue;
+
+			uint32_t Cost = Node.Cost + (Diagonal ? FLOW_COST_DIAGONAL : FLOW_COST_STRAIGHT);
+			if(Cost > MaxCost)
+				continue;
+
+			uint32_t NeighborIndex = Neighbor.x + Neighbor.y * Grid->Size.x;
+			if(Cost < Costs[NeighborIndex]) {
+				if(Costs[NeighborIndex] == FLOW_COST_NONE)
+					Touched.push_back(NeighborIndex);
+				Costs[NeighborIndex] = Cost;
+
+				// Neighbor flows back toward this tile
+				Directions[NeighborIndex] = (uint8_t)(i ^ 1);
+
+				Open.push_back(_Node(Cost, NeighborIndex));
+				std::push_heap(Open.begin(), Open.end(), std::greater<_Node>());
+			}
+		}
+	}
+}
+
+// Get the normalized direction to travel from a position, or a zero vector if no flow exists
+glm::vec2 _FlowField::GetDirection(const glm::vec2 &Position) const {
+	glm::ivec2 Coord = Grid->GetValidCoord(glm::ivec2(Position));
+
+	uint8_t Direction = Directions[Coord.x + Coord.y * Grid->Size.x];
+	if(Direction == FLOW_DIRECTION_NONE)
+		return glm::vec2(0.0f);
+
+	// Steer toward the center of the next tile
+	glm::vec2 Next = glm::vec2(Coord + FlowOffsets[Direction]) + glm::vec2(0.5f);
+	glm::vec2 Delta = Next - Position;
+	if(Delta.x == 0.0f && Delta.y == 0.0f)
+		return glm::vec2(0.0f);
+
+	return glm::normalize(Delta);
+}
@@ -0,0 +1,61 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <glm/vec2.hpp>
+#include <vector>
+#include <cstdint>
+
+// Forward Declarations
+class _Grid;
+
+// Integration field pointing every reachable tile toward a single goal tile
+class _FlowField {
+
+	public:
+
+		_FlowField(const _Grid *Grid);
+
+		void Build(const glm::ivec2 &Goal, int Radius);
+		glm::vec2 GetDirection(const glm::vec2 &Position) const;
+
+		// Attributes
+		glm::ivec2 Goal;
+		int IdleTicks;
+
+	private:
+
+		struct _Node {
+			_Node() { }
+			_Node(uint32_t Cost, uint32_t Index) : Cost(Cost), Index(Index) { }
+			bool operator>(const _Node &Node) const { return Cost > Node.Cost; }
+
+			uint32_t Cost;
+			uint32_t Index;
+		};
+
+		const _Grid *Grid;
+
+		// Field data
+		std::vector<uint32_t> Costs;
+		std::vector<uint8_t> Directions;
+		std::vector<_Node> Open;
+		std::vector<uint32_t> Touched;
+
+};
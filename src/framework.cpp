@@ -18,10 +18,12 @@
 #include <framework.h>
 #include <states/null.h>
 #include <states/convert.h>
+#include <states/compare.h>
 #include <states/client.h>
 #include <states/editor.h>
 #include <states/benchmark.h>
 #include <states/dedicated.h>
+#include <states/bots.h>
 #include <ae/network.h>
 #include <config.h>
 #include <ae/graphics.h>
@@ -46,6 +48,7 @@ void _Framework::Init(int ArgumentCount, char **Arguments) {
 	RequestedState = nullptr;
 	FrameLimit = nullptr;
 	Done = false;
+	ExitCode = 0;
 	TimeStepAccumulator = 0.0;
 	TimeStep = GAME_TIMESTEP;
 	FrameworkState = INIT;
@@ -116,10 +119,43 @@ void _Framework::Init(int ArgumentCount, char **Arguments) {
 		}
 		else if(Token == "-benchmark") {
 			State = &BenchmarkState;
+			if(TokensRemaining && Arguments[i+1][0] != '-')
+				BenchmarkState.SetParam1(Arguments[++i]);
 		}
 		else if(Token == "-dedicated") {
 			State = &DedicatedState;
 		}
+		else if(Token == "-record" && TokensRemaining > 0) {
+			DedicatedState.SetRecordPath(Arguments[++i]);
+		}
+		else if(Token == "-replay" && TokensRemaining > 0) {
+			State = &DedicatedState;
+			DedicatedState.SetReplayPath(Arguments[++i]);
+		}
+		else if(Token == "-hash" && TokensRemaining > 0) {
+			DedicatedState.SetHashLevel(atoi(Arguments[++i]));
+		}
+		else if(Token == "-bots" && TokensRemaining > 0) {
+			State = &BotState;
+			BotState.SetBotCount(atoi(Arguments[++i]));
+		}
+		else if(Token == "-bot_host" && TokensRemaining > 0) {
+			BotState.SetHostAddress(Arguments[++i]);
+		}
+		else if(Token == "-bot_map" && TokensRemaining > 0) {
+			BotState.SetMapName(Arguments[++i]);
+		}
+		else if(Token == "-bot_attack" && TokensRemaining > 0) {
+			BotState.SetAttackRate(atof(Arguments[++i]));
+		}
+		else if(Token == "-bot_time" && TokensRemaining > 0) {
+			BotState.SetDuration(atof(Arguments[++i]));
+		}
+		else if(Token == "-compare" && TokensRemaining > 1) {
+			State = &CompareState;
+			CompareState.SetPaths(Arguments[i+1], Arguments[i+2]);
+			i += 2;
+		}
 	}
 
 	// Initialize network subsystem
@@ -132,7 +168,16 @@ void _Framework::Init(int ArgumentCount, char **Arguments) {
 
 		DedicatedState.SetNetworkPort(NetworkPort);
 	}
-	else if(State == &ConvertState) {
+	else if(State == &BotState) {
+		LoadAssets(true);
+		FrameLimit = new ae::_FrameLimit(120.0, false);
+
+		BotState.SetNetworkPort(NetworkPort);
+	}
+	else if(State == &ConvertState || State == &CompareState) {
+	}
+	else if(State == &BenchmarkState && BenchmarkState.IsHeadless()) {
+		LoadAssets(true);
 	}
 	else {
 
@@ -51,6 +51,8 @@ class _Framework {
 
 		bool GetDone() { return Done; }
 		void SetDone(bool Done) { this->Done = Done; }
+		int GetExitCode() { return ExitCode; }
+		void SetExitCode(int ExitCode) { this->ExitCode = ExitCode; }
 
 		ae::_State *GetState() { return State; }
 		void ChangeState(ae::_State *RequestedState);
@@ -63,6 +65,7 @@ class _Framework {
 		// States
 		ae::_State *State, *RequestedState;
 		bool Done;
+		int ExitCode;
 		StateType FrameworkState;
 
 		// Time
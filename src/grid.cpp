@@ -23,10 +23,12 @@
 #include <constants.h>
 #include <stats.h>
 #include <map.h>
+#include <arena.h>
 #include <glm/gtx/norm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 
 // Constructor
 _Grid::_Grid() :
@@ -69,6 +71,8 @@ void _Grid::AddObject(_Object *Object) {
 	for(int i = Bounds[0]; i <= Bounds[2]; i++) {
 		for(int j = Bounds[1]; j <= Bounds[3]; j++) {
 			Tiles[i][j].Objects.push_front(Object);
+			if(BlocksTile(Object, i, j))
+				Tiles[i][j].BlockCount++;
 		}
 	}
 }
@@ -88,6 +92,9 @@ void _Grid::RemoveObject(const _Object *Object) {
 
 	for(int i = Bounds[0]; i <= Bounds[2]; i++) {
 		for(int j = Bounds[1]; j <= Bounds[3]; j++) {
+			if(BlocksTile(Object, i, j))
+				Tiles[i][j].BlockCount--;
+
 			for(auto Iterator = Tiles[i][j].Objects.begin(); Iterator != Tiles[i][j].Objects.end(); ++Iterator) {
 				if(*Iterator == Object) {
 					Tiles[i][j].Objects.erase(Iterator);
@@ -98,29 +105,54 @@ void _Grid::RemoveObject(const _Object *Object) {
 	}
 }
 
+// Returns the objects whose shapes overlap a min max AABB
+void _Grid::QueryObjects(const glm::vec4 &AABB, _ArenaVector<_Object *> &Objects) const {
+
+	// Get tile range
+	glm::ivec4 Bounds;
+	Bounds[0] = glm::clamp((int)AABB[0], 0, Size.x - 1);
+	Bounds[1] = glm::clamp((int)AABB[1], 0, Size.y - 1);
+	Bounds[2] = glm::clamp((int)AABB[2], 0, Size.x - 1);
+	Bounds[3] = glm::clamp((int)AABB[3], 0, Size.y - 1);
+
+	for(int j = Bounds[1]; j <= Bounds[3]; j++) {
+		for(int i = Bounds[0]; i <= Bounds[2]; i++) {
+			for(auto &Object : Tiles[i][j].Objects) {
+				if(!IsFirstTile(Object, i, j, Bounds))
+					continue;
+
+				if(Object->CheckAABB(AABB))
+					Objects.PushBack(Object);
+			}
+		}
+	}
+}
+
 // Returns a list of objects that an object is colliding with
-void _Grid::CheckCollisions(const _Object *Object, std::list<_Push> &Pushes, bool &AxisAlignedPush) const {
+void _Grid::CheckCollisions(const _Object *Object, const glm::vec2 &Position, _ArenaVector<_Push> &Pushes, bool &AxisAlignedPush) const {
 
 	// Get the object's bounding rectangle
 	glm::ivec4 Bounds;
-	GetTileBounds(Object, Bounds);
+	GetTileBounds(Object, Position, Bounds);
 
 	for(int j = Bounds[1]; j <= Bounds[3]; j++) {
 		for(int i = Bounds[0]; i <= Bounds[2]; i++) {
-			for(auto Iterator = Tiles[i][j].Objects.begin(); Iterator != Tiles[i][j].Objects.end(); ++Iterator) {
-				_Object *PotentialObject = *Iterator;
-				if(PotentialObject == Object || PotentialObject->Shape->LastCollisionID == Object->NetworkID)
+			for(auto &PotentialObject : Tiles[i][j].Objects) {
+				if(PotentialObject == Object || !IsFirstTile(PotentialObject, i, j, Bounds))
 					continue;
 
 				if(Object->Shape->IsAABB()) {
-
+					_Push Push;
+					if(PotentialObject->CheckBox(Position, glm::vec2(Object->Shape->HalfWidth), Push.Direction, AxisAlignedPush)) {
+						Push.Object = PotentialObject;
+						Pushes.PushBack(Push);
+					}
 				}
 				else {
 					_Push Push;
-					if(PotentialObject->CheckCircle(glm::vec2(Object->Physics->Position), Object->Shape->HalfWidth[0], Push.Direction, AxisAlignedPush)) {
+					if(PotentialObject->CheckCircle(Position, Object->Shape->HalfWidth[0], Push.Direction, AxisAlignedPush)) {
 						Push.Object = PotentialObject;
-						Pushes.push_back(Push);
-						PotentialObject->Shape->LastCollisionID = Object->NetworkID;
+						Pushes.PushBack(Push);
 					}
 				}
 			}
@@ -128,34 +160,163 @@ void _Grid::CheckCollisions(const _Object *Object, std::list<_Push> &Pushes, boo
 	}
 }
 
-// Make sure the object doesn't go outside the bounds of the map
-void _Grid::ClampObject(_Object *Object) const {
-	if(Object->Shape->IsAABB()) {
-		if(Object->Physics->Position.x - Object->Shape->HalfWidth[0] < 0)
-			Object->Physics->Position.x = Object->Shape->HalfWidth[0];
+// Find the earliest time of impact for an object moving by delta, returns false if nothing is hit
+bool _Grid::SweepObject(const _Object *Object, const glm::vec2 &Origin, const glm::vec2 &Delta, float &HitTime, glm::vec2 &Normal) const {
+	bool MoverIsAABB = Object->Shape->IsAABB();
+	glm::vec2 MoverHalfWidth = MoverIsAABB ? glm::vec2(Object->Shape->HalfWidth) : glm::vec2(Object->Shape->HalfWidth[0]);
 
-		if(Object->Physics->Position.y - Object->Shape->HalfWidth[1] < 0)
-			Object->Physics->Position.y = Object->Shape->HalfWidth[1];
+	// Get tile range covered by the sweep
+	glm::vec2 Start = glm::min(Origin, Origin + Delta) - MoverHalfWidth;
+	glm::vec2 End = glm::max(Origin, Origin + Delta) + MoverHalfWidth;
+	glm::ivec4 Bounds;
+	Bounds[0] = glm::clamp((int)Start.x, 0, Size.x - 1);
+	Bounds[1] = glm::clamp((int)Start.y, 0, Size.y - 1);
+	Bounds[2] = glm::clamp((int)End.x, 0, Size.x - 1);
+	Bounds[3] = glm::clamp((int)End.y, 0, Size.y - 1);
 
-		if(Object->Physics->Position.x + Object->Shape->HalfWidth[0] > Size.x)
-			Object->Physics->Position.x = Size.x - Object->Shape->HalfWidth[0];
+	bool Hit = false;
+	HitTime = 1.0f;
+	for(int j = Bounds[1]; j <= Bounds[3]; j++) {
+		for(int i = Bounds[0]; i <= Bounds[2]; i++) {
+			for(auto &PotentialObject : Tiles[i][j].Objects) {
+				if(PotentialObject == Object || !PotentialObject->Physics->CollisionResponse || !IsFirstTile(PotentialObject, i, j, Bounds))
+					continue;
+
+				// Sweep against the minkowski sum of both shapes
+				float Time;
+				glm::vec2 HitNormal;
+				glm::vec2 Center(PotentialObject->Physics->Position);
+				bool ObjectHit;
+				if(PotentialObject->Shape->IsAABB()) {
+					glm::vec2 HalfWidth(PotentialObject->Shape->HalfWidth);
+					if(MoverIsAABB)
+						ObjectHit = SweepRoundedBox(Origin, Delta, Center, HalfWidth + MoverHalfWidth, 0.0f, Time, HitNormal);
+					else
+						ObjectHit = SweepRoundedBox(Origin, Delta, Center, HalfWidth, MoverHalfWidth.x, Time, HitNormal);
+				}
+				else {
+					float Radius = PotentialObject->Shape->HalfWidth[0];
+					if(MoverIsAABB)
+						ObjectHit = SweepRoundedBox(Origin, Delta, Center, MoverHalfWidth, Radius, Time, HitNormal);
+					else {
+						ObjectHit = SweepCircle(Origin, Delta, Center, Radius + MoverHalfWidth.x, Time);
+						if(ObjectHit)
+							HitNormal = glm::normalize(Origin + Delta * Time - Center);
+					}
+				}
 
-		if(Object->Physics->Position.y + Object->Shape->HalfWidth[1] > Size.y)
-			Object->Physics->Position.y = Size.y - Object->Shape->HalfWidth[1];
+				if(ObjectHit && Time < HitTime) {
+					HitTime = Time;
+					Normal = HitNormal;
+					Hit = true;
+				}
+			}
+		}
+	}
+
+	return Hit;
+}
+
+// Sweep a point against a box with rounded corners, ignoring starting overlaps
+bool _Grid::SweepRoundedBox(const glm::vec2 &Origin, const glm::vec2 &Delta, const glm::vec2 &Center, const glm::vec2 &HalfWidth, float Radius, float &HitTime, glm::vec2 &Normal) const {
+	glm::vec2 Expanded = HalfWidth + glm::vec2(Radius);
+
+	// Slab test against the expanded box
+	float TimeMin = -HUGE_VAL;
+	float TimeMax = HUGE_VAL;
+	int Axis = 0;
+	for(int i = 0; i < 2; i++) {
+		float AABBMin = Center[i] - Expanded[i];
+		float AABBMax = Center[i] + Expanded[i];
+		if(Delta[i] == 0.0f) {
+			if(Origin[i] <= AABBMin || Origin[i] >= AABBMax)
+				return false;
+		}
+		else {
+			float OneOverDelta = 1.0f / Delta[i];
+			float HitTimeMin = (AABBMin - Origin[i]) * OneOverDelta;
+			float HitTimeMax = (AABBMax - Origin[i]) * OneOverDelta;
+			if(HitTimeMin > HitTimeMax)
+				std::swap(HitTimeMin, HitTimeMax);
+
+			if(HitTimeMin > TimeMin) {
+				TimeMin = HitTimeMin;
+				Axis = i;
+			}
+			TimeMax = std::min(TimeMax, HitTimeMax);
+		}
 	}
-	else {
-		if(Object->Physics->Position.x - Object->Shape->HalfWidth[0] < 0)
-			Object->Physics->Position.x = Object->Shape->HalfWidth[0];
 
-		if(Object->Physics->Position.y - Object->Shape->HalfWidth[0] < 0)
-			Object->Physics->Position.y = Object->Shape->HalfWidth[0];
+	// Missed, already overlapping, or out of range
+	if(TimeMin > TimeMax || TimeMin <= 0.0f || TimeMin > 1.0f)
+		return false;
 
-		if(Object->Physics->Position.x + Object->Shape->HalfWidth[0] > Size.x)
-			Object->Physics->Position.x = Size.x - Object->Shape->HalfWidth[0];
+	// Check for corner region
+	glm::vec2 Point = Origin + Delta * TimeMin - Center;
+	if(Radius > 0.0f && std::abs(Point.x) > HalfWidth.x && std::abs(Point.y) > HalfWidth.y) {
+		glm::vec2 Corner = Center + glm::vec2(Point.x < 0.0f ? -HalfWidth.x : HalfWidth.x, Point.y < 0.0f ? -HalfWidth.y : HalfWidth.y);
+		if(!SweepCircle(Origin, Delta, Corner, Radius, HitTime))
+			return false;
 
-		if(Object->Physics->Position.y + Object->Shape->HalfWidth[0] > Size.y)
-			Object->Physics->Position.y = Size.y - Object->Shape->HalfWidth[0];
+		Normal = glm::normalize(Origin + Delta * HitTime - Corner);
+		return true;
 	}
+
+	HitTime = TimeMin;
+	Normal = glm::vec2(0.0f);
+	Normal[Axis] = Delta[Axis] < 0.0f ? 1.0f : -1.0f;
+
+	return true;
+}
+
+// Sweep a point against a circle, ignoring starting overlaps
+bool _Grid::SweepCircle(const glm::vec2 &Origin, const glm::vec2 &Delta, const glm::vec2 &Center, float Radius, float &HitTime) const {
+	glm::vec2 Offset = Origin - Center;
+	float A = glm::dot(Delta, Delta);
+	float B = glm::dot(Offset, Delta);
+	float C = glm::dot(Offset, Offset) - Radius * Radius;
+
+	// Moving away or already inside
+	if(A == 0.0f || C <= 0.0f || B >= 0.0f)
+		return false;
+
+	float Discriminant = B * B - A * C;
+	if(Discriminant < 0.0f)
+		return false;
+
+	HitTime = (-B - std::sqrt(Discriminant)) / A;
+
+	return HitTime >= 0.0f && HitTime <= 1.0f;
+}
+
+// Make sure the object doesn't go outside the bounds of the map
+void _Grid::ClampObject(const _Object *Object, glm::vec2 &Position) const {
+	glm::vec2 HalfWidth = Object->Shape->IsAABB() ? glm::vec2(Object->Shape->HalfWidth) : glm::vec2(Object->Shape->HalfWidth[0]);
+
+	if(Position.x - HalfWidth.x < 0)
+		Position.x = HalfWidth.x;
+
+	if(Position.y - HalfWidth.y < 0)
+		Position.y = HalfWidth.y;
+
+	if(Position.x + HalfWidth.x > Size.x)
+		Position.x = Size.x - HalfWidth.x;
+
+	if(Position.y + HalfWidth.y > Size.y)
+		Position.y = Size.y - HalfWidth.y;
+}
+
+// Determines if an object is a static blocker covering a tile's center
+bool _Grid::BlocksTile(const _Object *Object, int IndexX, int IndexY) const {
+	if(!Object->Shape->IsAABB() || !Object->Physics->CollisionResponse)
+		return false;
+
+	// Ignore objects that move
+	if(Object->HasComponent("ai") || Object->HasComponent("controller"))
+		return false;
+
+	glm::vec2 Center(IndexX + 0.5f, IndexY + 0.5f);
+	return std::abs(Center.x - Object->Physics->Position.x) < Object->Shape->HalfWidth[0] && std::abs(Center.y - Object->Physics->Position.y) < Object->Shape->HalfWidth[1];
 }
 
 // Checks bullet collisions with objects and walls
@@ -208,7 +369,7 @@ void _Grid::CheckBulletCollisions(const _Shot *Shot, _Impact &Impact) const {
 		// Check for object intersections
 		for(auto &Iterator : Tiles[TileTracer.x][TileTracer.y].Objects) {
 			_Object *Object = Iterator;
-			if(Object != Shot->Parent->Parent) {
+			if(Object->Handle != Shot->Parent->Parent) {
 				float Distance = RayObjectIntersection(Shot->Position, Shot->Direction, Object);
 				if(Distance < MinDistance && Distance > 0.0f) {
 					Impact.Object = Object;
@@ -450,18 +611,31 @@ float _Grid::RayObjectIntersection(const glm::vec2 &Origin, const glm::vec2 &Dir
 
 // Returns the tile range that an object touches
 void _Grid::GetTileBounds(const _Object *Object, glm::ivec4 &Bounds) const {
+	GetTileBounds(Object, glm::vec2(Object->Physics->Position), Bounds);
+}
+
+// Returns the tile range that an object would touch at a position
+void _Grid::GetTileBounds(const _Object *Object, const glm::vec2 &Position, glm::ivec4 &Bounds) const {
 
 	// Shape is AABB
 	if(Object->Shape->IsAABB()) {
-		Bounds[0] = glm::clamp((int)(Object->Physics->Position.x - Object->Shape->HalfWidth.x), 0, Size.x - 1);
-		Bounds[1] = glm::clamp((int)(Object->Physics->Position.y - Object->Shape->HalfWidth.y), 0, Size.y - 1);
-		Bounds[2] = glm::clamp((int)(Object->Physics->Position.x + Object->Shape->HalfWidth.x), 0, Size.x - 1);
-		Bounds[3] = glm::clamp((int)(Object->Physics->Position.y + Object->Shape->HalfWidth.y), 0, Size.y - 1);
+		Bounds[0] = glm::clamp((int)(Position.x - Object->Shape->HalfWidth.x), 0, Size.x - 1);
+		Bounds[1] = glm::clamp((int)(Position.y - Object->Shape->HalfWidth.y), 0, Size.y - 1);
+		Bounds[2] = glm::clamp((int)(Position.x + Object->Shape->HalfWidth.x), 0, Size.x - 1);
+		Bounds[3] = glm::clamp((int)(Position.y + Object->Shape->HalfWidth.y), 0, Size.y - 1);
 	}
 	else {
-		Bounds[0] = glm::clamp((int)(Object->Physics->Position.x - Object->Shape->HalfWidth.x), 0, Size.x - 1);
-		Bounds[1] = glm::clamp((int)(Object->Physics->Position.y - Object->Shape->HalfWidth.x), 0, Size.y - 1);
-		Bounds[2] = glm::clamp((int)(Object->Physics->Position.x + Object->Shape->HalfWidth.x), 0, Size.x - 1);
-		Bounds[3] = glm::clamp((int)(Object->Physics->Position.y + Object->Shape->HalfWidth.x), 0, Size.y - 1);
+		Bounds[0] = glm::clamp((int)(Position.x - Object->Shape->HalfWidth.x), 0, Size.x - 1);
+		Bounds[1] = glm::clamp((int)(Position.y - Object->Shape->HalfWidth.x), 0, Size.y - 1);
+		Bounds[2] = glm::clamp((int)(Position.x + Object->Shape->HalfWidth.x), 0, Size.x - 1);
+		Bounds[3] = glm::clamp((int)(Position.y + Object->Shape->HalfWidth.x), 0, Size.y - 1);
 	}
 }
+
+// Objects spanning several tiles are only visited from their first tile inside the query bounds
+bool _Grid::IsFirstTile(const _Object *Object, int X, int Y, const glm::ivec4 &Bounds) const {
+	glm::ivec4 ObjectBounds;
+	GetTileBounds(Object, ObjectBounds);
+
+	return X == std::max(ObjectBounds[0], Bounds[0]) && Y == std::max(ObjectBounds[1], Bounds[1]);
+}
@@ -28,6 +28,7 @@ class _Object;
 class _Shot;
 class _CollisionShape;
 struct _Impact;
+template<class T> class _ArenaVector;
 
 namespace ae {
 	class _Texture;
@@ -35,10 +36,11 @@ namespace ae {
 
 // Holds data for a single tile
 struct _Tile {
-	_Tile() : TextureIndex(0) { }
+	_Tile() : TextureIndex(0), BlockCount(0) { }
 
 	std::list<_Object *> Objects;
 	uint32_t TextureIndex;
+	uint32_t BlockCount;
 };
 
 struct _Push {
@@ -63,11 +65,16 @@ class _Grid {
 
 		glm::ivec2 GetValidCoord(const glm::ivec2 &Coord) const { return glm::clamp(Coord, glm::ivec2(0), Size - 1); }
 		void GetTileBounds(const _Object *Object, glm::ivec4 &Bounds) const;
+		void GetTileBounds(const _Object *Object, const glm::vec2 &Position, glm::ivec4 &Bounds) const;
+		bool IsFirstTile(const _Object *Object, int X, int Y, const glm::ivec4 &Bounds) const;
+		void QueryObjects(const glm::vec4 &AABB, _ArenaVector<_Object *> &Objects) const;
 
 		// Collision
-		void CheckCollisions(const _Object *Object, std::list<_Push> &Pushes, bool &AxisAlignedPush) const;
-		void ClampObject(_Object *Object) const;
+		void CheckCollisions(const _Object *Object, const glm::vec2 &Position, _ArenaVector<_Push> &Pushes, bool &AxisAlignedPush) const;
+		bool SweepObject(const _Object *Object, const glm::vec2 &Origin, const glm::vec2 &Delta, float &HitTime, glm::vec2 &Normal) const;
+		void ClampObject(const _Object *Object, glm::vec2 &Position) const;
 		bool CanShootThrough(int IndexX, int IndexY) const { return true; }
+		bool IsWalkable(int IndexX, int IndexY) const { return !Tiles[IndexX][IndexY].BlockCount; }
 		bool IsVisible(const glm::vec2 &Start, const glm::vec2 &End) const;
 		void CheckBulletCollisions(const _Shot *Shot, _Impact &Impact) const;
 		float RayObjectIntersection(const glm::vec2 &Origin, const glm::vec2 &Direction, const _Object *Object) const;
@@ -78,4 +85,8 @@ class _Grid {
 
 	private:
 
+		bool BlocksTile(const _Object *Object, int IndexX, int IndexY) const;
+		bool SweepRoundedBox(const glm::vec2 &Origin, const glm::vec2 &Delta, const glm::vec2 &Center, const glm::vec2 &HalfWidth, float Radius, float &HitTime, glm::vec2 &Normal) const;
+		bool SweepCircle(const glm::vec2 &Origin, const glm::vec2 &Delta, const glm::vec2 &Center, float Radius, float &HitTime) const;
+
 };
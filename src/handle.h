@@ -0,0 +1,97 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Weak reference made of a slot index and the generation the slot had when it was handed out
+struct _Handle {
+
+	_Handle() : Index(0), Generation(0) { }
+
+	bool IsValid() const { return Generation != 0; }
+	bool operator==(const _Handle &Handle) const { return Index == Handle.Index && Generation == Handle.Generation; }
+	bool operator!=(const _Handle &Handle) const { return !(*this == Handle); }
+
+	uint32_t Index;
+	uint32_t Generation;
+};
+
+// Slot table resolving handles in constant time, stale handles resolve to nullptr
+template<class T> class _HandlePool {
+
+	public:
+
+		_Handle Create(T *Item) {
+			_Handle Handle;
+			if(FreeSlots.empty()) {
+				Handle.Index = (uint32_t)Slots.size();
+				Slots.push_back({ nullptr, 1 });
+			}
+			else {
+				Handle.Index = FreeSlots.back();
+				FreeSlots.pop_back();
+			}
+
+			_Slot &Slot = Slots[Handle.Index];
+			Slot.Item = Item;
+			Handle.Generation = Slot.Generation;
+
+			return Handle;
+		}
+
+		void Release(const _Handle &Handle) {
+			if(!Get(Handle))
+				return;
+
+			// Bump generation so outstanding handles stop resolving, zero is reserved for null handles
+			_Slot &Slot = Slots[Handle.Index];
+			Slot.Item = nullptr;
+			if(++Slot.Generation == 0)
+				Slot.Generation = 1;
+
+			FreeSlots.push_back(Handle.Index);
+		}
+
+		T *Get(const _Handle &Handle) const {
+			if(Handle.Index >= Slots.size())
+				return nullptr;
+
+			const _Slot &Slot = Slots[Handle.Index];
+			if(Slot.Generation != Handle.Generation)
+				return nullptr;
+
+			return Slot.Item;
+		}
+
+		size_t GetCount() const { return Slots.size() - FreeSlots.size(); }
+
+	private:
+
+		struct _Slot {
+			T *Item;
+			uint32_t Generation;
+		};
+
+		std::vector<_Slot> Slots;
+		std::vector<uint32_t> FreeSlots;
+
+};
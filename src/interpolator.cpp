@@ -0,0 +1,69 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <interpolator.h>
+#include <constants.h>
+#include <algorithm>
+#include <cmath>
+
+// Constructor
+_Interpolator::_Interpolator() :
+	Interval(NETWORK_INTERP_DELAY / 2.0),
+	Jitter(0.0),
+	LastTime(0),
+	HasLastTime(false),
+	RTT(0.0),
+	RTTJitter(0.0),
+	HasRTT(false),
+	Delay(NETWORK_INTERP_DELAY) {
+
+}
+
+// Measure the gap since the last snapshot
+void _Interpolator::AddSnapshot(uint16_t TimeSteps) {
+	if(HasLastTime) {
+		double Gap = uint16_t(TimeSteps - LastTime);
+		Interval += (Gap - Interval) * NETWORK_INTERP_SMOOTHING;
+		Jitter += (std::abs(Gap - Interval) - Jitter) * NETWORK_INTERP_SMOOTHING;
+		UpdateDelay();
+	}
+
+	LastTime = TimeSteps;
+	HasLastTime = true;
+}
+
+// Track how much the round trip time moves between updates
+void _Interpolator::SetRTT(double RTT) {
+	if(HasRTT) {
+		double Change = std::abs(RTT - this->RTT) / (1000.0 * GAME_TIMESTEP);
+		RTTJitter += (Change - RTTJitter) * NETWORK_INTERP_SMOOTHING;
+		UpdateDelay();
+	}
+
+	this->RTT = RTT;
+	HasRTT = true;
+}
+
+// Stay one snapshot interval plus a jitter margin behind, growing quickly and shrinking a tick at a time
+void _Interpolator::UpdateDelay() {
+	int Target = (int)std::ceil(Interval + NETWORK_INTERP_JITTER_SCALE * (Jitter + RTTJitter)) + 1;
+	Target = std::min(std::max(Target, NETWORK_INTERP_MIN_DELAY), NETWORK_INTERP_MAX_DELAY);
+	if(Target > Delay)
+		Delay = Target;
+	else if(Target < Delay - 1)
+		Delay--;
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <cstdint>
+
+// Adapts the delay used to render remote objects to how evenly snapshots arrive
+class _Interpolator {
+
+	public:
+
+		_Interpolator();
+
+		void AddSnapshot(uint16_t TimeSteps);
+		void SetRTT(double RTT);
+
+		uint16_t GetRenderTime(uint16_t TimeSteps) const { return uint16_t(TimeSteps - Delay); }
+		int GetDelay() const { return Delay; }
+		double GetJitter() const { return Jitter + RTTJitter; }
+
+	private:
+
+		void UpdateDelay();
+
+		// Snapshot arrival in ticks
+		double Interval;
+		double Jitter;
+		uint16_t LastTime;
+		bool HasLastTime;
+
+		// Round trip time in milliseconds and its variation in ticks
+		double RTT;
+		double RTTJitter;
+		bool HasRTT;
+
+		int Delay;
+
+};
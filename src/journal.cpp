@@ -0,0 +1,195 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <journal.h>
+#include <ae/network.h>
+#include <ae/buffer.h>
+#include <cstring>
+
+// File identifier and format version
+static const char JOURNAL_MAGIC[4] = { 'E', 'S', 'D', 'J' };
+static const uint8_t JOURNAL_VERSION = 1;
+
+// Constructor
+_Journal::_Journal() :
+	Bytes(0),
+	NextPeerID(0) {
+
+}
+
+// Open a journal for recording
+bool _Journal::OpenWrite(const std::string &Path) {
+	Out.open(Path, std::ios::binary | std::ios::trunc);
+	if(!Out)
+		return false;
+
+	Out.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+	Out.put((char)JOURNAL_VERSION);
+	Bytes = sizeof(JOURNAL_MAGIC) + 1;
+
+	return true;
+}
+
+// Record a network event before the server handles it
+void _Journal::WriteEvent(const ae::_NetworkEvent &Event) {
+	if(!Out.is_open())
+		return;
+
+	switch(Event.Type) {
+		case ae::_NetworkEvent::CONNECT:
+			PeerIDs[Event.Peer] = NextPeerID;
+			Out.put((char)CONNECT);
+			Bytes++;
+			WriteVarint(NextPeerID++);
+		break;
+		case ae::_NetworkEvent::DISCONNECT: {
+			auto Iterator = PeerIDs.find(Event.Peer);
+			if(Iterator == PeerIDs.end())
+				return;
+
+			Out.put((char)DISCONNECT);
+			Bytes++;
+			WriteVarint(Iterator->second);
+			PeerIDs.erase(Iterator);
+		} break;
+		case ae::_NetworkEvent::PACKET: {
+			auto Iterator = PeerIDs.find(Event.Peer);
+			if(Iterator == PeerIDs.end())
+				return;
+
+			Out.put((char)PACKET);
+			Bytes++;
+			WriteVarint(Iterator->second);
+			WriteData(Event.Data->GetData(), (uint32_t)Event.Data->GetCurrentSize());
+		} break;
+	}
+}
+
+// Record a map being loaded
+void _Journal::WriteMap(const std::string &MapName) {
+	if(!Out.is_open())
+		return;
+
+	Out.put((char)MAP);
+	Bytes++;
+	WriteData(MapName.c_str(), (uint32_t)MapName.length());
+}
+
+// Mark the end of a server update
+void _Journal::WriteTick(double FrameTime) {
+	if(!Out.is_open())
+		return;
+
+	Out.put((char)TICK);
+	Out.write((const char *)&FrameTime, sizeof(FrameTime));
+	Bytes += 1 + sizeof(FrameTime);
+}
+
+// Open a journal for playback
+bool _Journal::OpenRead(const std::string &Path) {
+	In.open(Path, std::ios::binary);
+	if(!In)
+		return false;
+
+	char Magic[sizeof(JOURNAL_MAGIC)];
+	In.read(Magic, sizeof(Magic));
+	int Version = In.get();
+	if(!In || memcmp(Magic, JOURNAL_MAGIC, sizeof(Magic)) != 0 || Version != JOURNAL_VERSION)
+		return false;
+
+	Bytes = sizeof(JOURNAL_MAGIC) + 1;
+
+	return true;
+}
+
+// Read the next record, returns false at the end of the journal
+bool _Journal::ReadRecord(_Record &Record) {
+	int Type = In.get();
+	if(Type == std::char_traits<char>::eof())
+		return false;
+
+	Bytes++;
+	Record.Type = (RecordType)Type;
+	Record.PeerID = 0;
+	Record.FrameTime = 0.0;
+	Record.Data.clear();
+	switch(Record.Type) {
+		case TICK:
+			In.read((char *)&Record.FrameTime, sizeof(Record.FrameTime));
+			Bytes += sizeof(Record.FrameTime);
+			return (bool)In;
+		case CONNECT:
+		case DISCONNECT:
+			return ReadVarint(Record.PeerID);
+		case PACKET:
+			return ReadVarint(Record.PeerID) && ReadData(Record.Data);
+		case MAP:
+			return ReadData(Record.Data);
+	}
+
+	return false;
+}
+
+// Write an unsigned integer using 7 bits per byte
+void _Journal::WriteVarint(uint32_t Value) {
+	while(Value >= 0x80) {
+		Out.put((char)((Value & 0x7F) | 0x80));
+		Value >>= 7;
+		Bytes++;
+	}
+
+	Out.put((char)Value);
+	Bytes++;
+}
+
+// Read an unsigned integer written by WriteVarint
+bool _Journal::ReadVarint(uint32_t &Value) {
+	Value = 0;
+	for(int Shift = 0; Shift < 35; Shift += 7) {
+		int Byte = In.get();
+		if(Byte == std::char_traits<char>::eof())
+			return false;
+
+		Bytes++;
+		Value |= (uint32_t)(Byte & 0x7F) << Shift;
+		if(!(Byte & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+// Write a length prefixed block
+void _Journal::WriteData(const char *Data, uint32_t Size) {
+	WriteVarint(Size);
+	Out.write(Data, Size);
+	Bytes += Size;
+}
+
+// Read a length prefixed block
+bool _Journal::ReadData(std::vector<char> &Data) {
+	uint32_t Size;
+	if(!ReadVarint(Size))
+		return false;
+
+	Data.resize(Size);
+	if(Size)
+		In.read(Data.data(), Size);
+	Bytes += Size;
+
+	return (bool)In;
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <unordered_map>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Forward Declarations
+namespace ae {
+	class _Peer;
+	struct _NetworkEvent;
+}
+
+// Compact binary log of everything the server receives, used to replay a session offline
+class _Journal {
+
+	public:
+
+		enum RecordType : uint8_t {
+			TICK,
+			CONNECT,
+			DISCONNECT,
+			PACKET,
+			MAP,
+		};
+
+		struct _Record {
+			RecordType Type;
+			uint32_t PeerID;
+			double FrameTime;
+			std::vector<char> Data;
+		};
+
+		_Journal();
+
+		// Recording
+		bool OpenWrite(const std::string &Path);
+		void WriteEvent(const ae::_NetworkEvent &Event);
+		void WriteMap(const std::string &MapName);
+		void WriteTick(double FrameTime);
+
+		// Playback
+		bool OpenRead(const std::string &Path);
+		bool ReadRecord(_Record &Record);
+
+		uint64_t GetBytes() const { return Bytes; }
+
+	private:
+
+		void WriteVarint(uint32_t Value);
+		bool ReadVarint(uint32_t &Value);
+		void WriteData(const char *Data, uint32_t Size);
+		bool ReadData(std::vector<char> &Data);
+
+		std::ofstream Out;
+		std::ifstream In;
+		uint64_t Bytes;
+
+		// Peers are numbered in connection order since pointers don't survive a restart
+		std::unordered_map<const ae::_Peer *, uint32_t> PeerIDs;
+		uint32_t NextPeerID;
+
+};
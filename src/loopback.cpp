@@ -0,0 +1,270 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <loopback.h>
+#include <ae/buffer.h>
+#include <ae/peer.h>
+
+// Copy a packet once so it can be shared with other threads
+static std::shared_ptr<const std::vector<char>> CreatePayload(const ae::_Buffer &Buffer) {
+	const char *Data = Buffer.GetData();
+	return std::make_shared<const std::vector<char>>(Data, Data + Buffer.GetCurrentSize());
+}
+
+// Give the receiver its own buffer to read and delete
+static ae::_Buffer *CreateBuffer(const _LoopbackMessage &Message) {
+	if(!Message.Payload)
+		return nullptr;
+
+	return new ae::_Buffer(const_cast<char *>(Message.Payload->data()), (unsigned int)Message.Payload->size());
+}
+
+// Constructor
+_LoopbackServerTransport::_LoopbackServerTransport() :
+	UpdateTimer(0.0),
+	UpdatePeriod(0.0),
+	SpeedTimer(0.0),
+	SentBytes(0),
+	SentSpeed(0.0f) {
+}
+
+// Destructor
+_LoopbackServerTransport::~_LoopbackServerTransport() {
+	while(!Events.empty()) {
+		delete Events.front().Data;
+		Events.pop();
+	}
+
+	for(auto &Peer : Peers)
+		delete Peer;
+}
+
+// Create a connection for a client, the server thread picks it up on its next update
+std::shared_ptr<_LoopbackConnection> _LoopbackServerTransport::Accept() {
+	std::shared_ptr<_LoopbackConnection> Connection(new _LoopbackConnection());
+
+	std::lock_guard<std::mutex> Lock(PendingMutex);
+	Pending.push_back(Connection);
+
+	return Connection;
+}
+
+// Accept pending connections and drain client queues into events
+void _LoopbackServerTransport::Update(double FrameTime) {
+	UpdateTimer += FrameTime;
+
+	// Update speed stats once a second
+	SpeedTimer += FrameTime;
+	if(SpeedTimer >= 1.0) {
+		SentSpeed = (float)(SentBytes / SpeedTimer);
+		SentBytes = 0;
+		SpeedTimer = 0.0;
+	}
+
+	// Take pending connections
+	std::vector<std::shared_ptr<_LoopbackConnection>> Accepted;
+	{
+		std::lock_guard<std::mutex> Lock(PendingMutex);
+		Accepted.swap(Pending);
+	}
+
+	for(auto &Connection : Accepted) {
+		ae::_Peer *Peer = new ae::_Peer(nullptr);
+		Peers.push_back(Peer);
+		Connections[Peer] = { Connection, std::prev(Peers.end()) };
+		Connection->ToClient.Push({ ae::_NetworkEvent::CONNECT, nullptr });
+		QueueEvent(ae::_NetworkEvent::CONNECT, Peer, nullptr);
+	}
+
+	// Receive from clients
+	for(auto &Peer : Peers) {
+		_LoopbackMessage Message;
+		while(Connections[Peer].Connection->ToServer.Pop(Message))
+			QueueEvent(Message.Type, Peer, CreateBuffer(Message));
+	}
+}
+
+// Get next event
+bool _LoopbackServerTransport::GetNetworkEvent(ae::_NetworkEvent &Event) {
+	if(Events.empty())
+		return false;
+
+	Event = Events.front();
+	Events.pop();
+
+	return true;
+}
+
+// Send packet to a client, peers without a connection are ignored
+void _LoopbackServerTransport::SendPacket(ae::_Buffer &Buffer, const ae::_Peer *Peer, ae::_Network::SendType Type, uint8_t Channel) {
+	auto Iterator = Connections.find(Peer);
+	if(Iterator == Connections.end())
+		return;
+
+	Iterator->second.Connection->ToClient.Push({ ae::_NetworkEvent::PACKET, CreatePayload(Buffer) });
+	SentBytes += Buffer.GetCurrentSize();
+}
+
+// Send the same payload to many clients
+void _LoopbackServerTransport::BroadcastPacket(ae::_Buffer &Buffer, const std::vector<const ae::_Peer *> &Peers, ae::_Network::SendType Type, uint8_t Channel) {
+	if(Peers.empty())
+		return;
+
+	std::shared_ptr<const std::vector<char>> Payload = CreatePayload(Buffer);
+	for(auto &Peer : Peers) {
+		auto Iterator = Connections.find(Peer);
+		if(Iterator != Connections.end()) {
+			Iterator->second.Connection->ToClient.Push({ ae::_NetworkEvent::PACKET, Payload });
+			SentBytes += Buffer.GetCurrentSize();
+		}
+	}
+}
+
+// Tell every client to disconnect and report them as gone
+void _LoopbackServerTransport::DisconnectAll() {
+	for(auto &Peer : Peers) {
+		Connections[Peer].Connection->ToClient.Push({ ae::_NetworkEvent::DISCONNECT, nullptr });
+		QueueEvent(ae::_NetworkEvent::DISCONNECT, Peer, nullptr);
+	}
+}
+
+// Remove a peer after its disconnect has been handled
+void _LoopbackServerTransport::DeletePeer(ae::_Peer *Peer) {
+	auto Iterator = Connections.find(Peer);
+	if(Iterator != Connections.end()) {
+		Peers.erase(Iterator->second.Iterator);
+		Connections.erase(Iterator);
+	}
+
+	delete Peer;
+}
+
+// Add an event for the server to handle
+void _LoopbackServerTransport::QueueEvent(ae::_NetworkEvent::EventType Type, ae::_Peer *Peer, ae::_Buffer *Data) {
+	ae::_NetworkEvent Event;
+	Event.Type = Type;
+	Event.Time = 0.0;
+	Event.Data = Data;
+	Event.Peer = Peer;
+	Events.push(Event);
+}
+
+// Constructor
+_LoopbackClientTransport::_LoopbackClientTransport(_LoopbackServerTransport *Server) :
+	Server(Server),
+	Connected(false),
+	SpeedTimer(0.0),
+	SentBytes(0),
+	ReceivedBytes(0),
+	SentSpeed(0.0f),
+	ReceiveSpeed(0.0f) {
+}
+
+// Destructor
+_LoopbackClientTransport::~_LoopbackClientTransport() {
+	if(Connected)
+		Connection->ToServer.Push({ ae::_NetworkEvent::DISCONNECT, nullptr });
+
+	while(!Events.empty()) {
+		delete Events.front().Data;
+		Events.pop();
+	}
+}
+
+// Drain the server queue into events
+void _LoopbackClientTransport::Update(double FrameTime) {
+
+	// Update speed stats once a second
+	SpeedTimer += FrameTime;
+	if(SpeedTimer >= 1.0) {
+		SentSpeed = (float)(SentBytes / SpeedTimer);
+		ReceiveSpeed = (float)(ReceivedBytes / SpeedTimer);
+		SentBytes = 0;
+		ReceivedBytes = 0;
+		SpeedTimer = 0.0;
+	}
+
+	if(!Connection)
+		return;
+
+	_LoopbackMessage Message;
+	while(Connection->ToClient.Pop(Message)) {
+		switch(Message.Type) {
+			case ae::_NetworkEvent::CONNECT:
+				Connected = true;
+			break;
+			case ae::_NetworkEvent::DISCONNECT:
+				if(!Connected)
+					continue;
+				Connected = false;
+			break;
+			case ae::_NetworkEvent::PACKET:
+				ReceivedBytes += Message.Payload->size();
+			break;
+		}
+
+		QueueEvent(Message.Type, CreateBuffer(Message));
+	}
+}
+
+// Get next event
+bool _LoopbackClientTransport::GetNetworkEvent(ae::_NetworkEvent &Event) {
+	if(Events.empty())
+		return false;
+
+	Event = Events.front();
+	Events.pop();
+
+	return true;
+}
+
+// Connect to the server, the address and port are ignored
+void _LoopbackClientTransport::Connect(const char *HostAddress, uint16_t Port) {
+	if(Connection)
+		return;
+
+	Connection = Server->Accept();
+}
+
+// Disconnect from the server
+void _LoopbackClientTransport::Disconnect(bool Force) {
+	if(!Connected)
+		return;
+
+	Connection->ToServer.Push({ ae::_NetworkEvent::DISCONNECT, nullptr });
+	Connected = false;
+	QueueEvent(ae::_NetworkEvent::DISCONNECT, nullptr);
+}
+
+// Send packet to the server
+void _LoopbackClientTransport::SendPacket(ae::_Buffer &Buffer, ae::_Network::SendType Type, uint8_t Channel) {
+	if(!Connected)
+		return;
+
+	SentBytes += Buffer.GetCurrentSize();
+	Connection->ToServer.Push({ ae::_NetworkEvent::PACKET, CreatePayload(Buffer) });
+}
+
+// Add an event for the client to handle
+void _LoopbackClientTransport::QueueEvent(ae::_NetworkEvent::EventType Type, ae::_Buffer *Data) {
+	ae::_NetworkEvent Event;
+	Event.Type = Type;
+	Event.Time = 0.0;
+	Event.Data = Data;
+	Event.Peer = nullptr;
+	Events.push(Event);
+}
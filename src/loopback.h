@@ -0,0 +1,182 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <transport.h>
+#include <unordered_map>
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <atomic>
+#include <utility>
+
+// Unbounded queue for one producer thread and one consumer thread
+template<class T> class _LoopbackQueue {
+
+	public:
+
+		_LoopbackQueue() : Head(new _Node()), Tail(Head) { }
+		~_LoopbackQueue() {
+			while(Head) {
+				_Node *Next = Head->Next.load(std::memory_order_relaxed);
+				delete Head;
+				Head = Next;
+			}
+		}
+
+		// Called only by the producer
+		void Push(const T &Value) {
+			_Node *Node = new _Node();
+			Node->Value = Value;
+			Tail->Next.store(Node, std::memory_order_release);
+			Tail = Node;
+		}
+
+		// Called only by the consumer, the old head node becomes free once its successor is read
+		bool Pop(T &Value) {
+			_Node *Next = Head->Next.load(std::memory_order_acquire);
+			if(!Next)
+				return false;
+
+			Value = std::move(Next->Value);
+			delete Head;
+			Head = Next;
+
+			return true;
+		}
+
+	private:
+
+		struct _Node {
+			_Node() : Value(), Next(nullptr) { }
+			T Value;
+			std::atomic<_Node *> Next;
+		};
+
+		_Node *Head;
+		_Node *Tail;
+
+};
+
+// Connect, disconnect or packet passed between threads, broadcasts share one payload
+struct _LoopbackMessage {
+	ae::_NetworkEvent::EventType Type;
+	std::shared_ptr<const std::vector<char>> Payload;
+};
+
+// One in-process connection between a client and the loopback server
+struct _LoopbackConnection {
+	_LoopbackQueue<_LoopbackMessage> ToServer;
+	_LoopbackQueue<_LoopbackMessage> ToClient;
+};
+
+// Server that only accepts clients from the same process, packets are always reliable and ordered
+class _LoopbackServerTransport : public _ServerTransport {
+
+	public:
+
+		_LoopbackServerTransport();
+		~_LoopbackServerTransport() override;
+
+		// Called from client threads
+		std::shared_ptr<_LoopbackConnection> Accept();
+
+		void Update(double FrameTime) override;
+		bool GetNetworkEvent(ae::_NetworkEvent &Event) override;
+		bool NeedsUpdate() override { return UpdateTimer >= UpdatePeriod; }
+		void ResetUpdateTimer() override { UpdateTimer = 0.0; }
+		void SetFakeLag(double Value) override { }
+		void SetUpdatePeriod(double Value) override { UpdatePeriod = Value; }
+
+		void SendPacket(ae::_Buffer &Buffer, const ae::_Peer *Peer, ae::_Network::SendType Type=ae::_Network::RELIABLE, uint8_t Channel=0) override;
+		void BroadcastPacket(ae::_Buffer &Buffer, const std::vector<const ae::_Peer *> &Peers, ae::_Network::SendType Type=ae::_Network::RELIABLE, uint8_t Channel=0) override;
+		const std::list<ae::_Peer *> &GetPeers() override { return Peers; }
+		void DisconnectAll() override;
+		void DeletePeer(ae::_Peer *Peer) override;
+
+		float GetSentSpeed() override { return SentSpeed; }
+
+	private:
+
+		// Connection and position in the peer list
+		struct _LoopbackPeer {
+			std::shared_ptr<_LoopbackConnection> Connection;
+			std::list<ae::_Peer *>::iterator Iterator;
+		};
+
+		void QueueEvent(ae::_NetworkEvent::EventType Type, ae::_Peer *Peer, ae::_Buffer *Data);
+
+		std::list<ae::_Peer *> Peers;
+		std::unordered_map<const ae::_Peer *, _LoopbackPeer> Connections;
+		std::queue<ae::_NetworkEvent> Events;
+
+		// Connections waiting for the server thread
+		std::mutex PendingMutex;
+		std::vector<std::shared_ptr<_LoopbackConnection>> Pending;
+
+		double UpdateTimer;
+		double UpdatePeriod;
+
+		// Stats
+		double SpeedTimer;
+		size_t SentBytes;
+		float SentSpeed;
+
+};
+
+// Client connected to a loopback server in the same process
+class _LoopbackClientTransport : public _ClientTransport {
+
+	public:
+
+		_LoopbackClientTransport(_LoopbackServerTransport *Server);
+		~_LoopbackClientTransport() override;
+
+		void Update(double FrameTime) override;
+		bool GetNetworkEvent(ae::_NetworkEvent &Event) override;
+		void ResetUpdateTimer() override { }
+		void SetFakeLag(double Value) override { }
+		void SetUpdatePeriod(double Value) override { }
+
+		void Connect(const char *HostAddress, uint16_t Port) override;
+		void Disconnect(bool Force=false) override;
+		bool IsConnected() override { return Connected; }
+		void SendPacket(ae::_Buffer &Buffer, ae::_Network::SendType Type=ae::_Network::RELIABLE, uint8_t Channel=0) override;
+
+		float GetSentSpeed() override { return SentSpeed; }
+		float GetReceiveSpeed() override { return ReceiveSpeed; }
+		uint32_t GetRTT() override { return 0; }
+
+	private:
+
+		void QueueEvent(ae::_NetworkEvent::EventType Type, ae::_Buffer *Data);
+
+		_LoopbackServerTransport *Server;
+		std::shared_ptr<_LoopbackConnection> Connection;
+		std::queue<ae::_NetworkEvent> Events;
+		bool Connected;
+
+		// Stats
+		double SpeedTimer;
+		size_t SentBytes;
+		size_t ReceivedBytes;
+		float SentSpeed;
+		float ReceiveSpeed;
+
+};
@@ -32,8 +32,9 @@ int main(int ArgumentCount, char **Arguments) {
 	}
 
 	// Shutdown
+	int ExitCode = Framework.GetExitCode();
 	Framework.Close();
 	Config.Close();
 
-	return 0;
+	return ExitCode;
 }
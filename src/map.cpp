@@ -28,7 +28,8 @@
 #include <objects/item.h>
 #include <objects/shot.h>
 #include <objects/ai.h>
-#include <ae/servernetwork.h>
+#include <objects/health.h>
+#include <transport.h>
 #include <ae/peer.h>
 #include <constants.h>
 #include <ae/graphics.h>
@@ -39,6 +40,13 @@
 #include <ae/camera.h>
 #include <ae/mesh.h>
 #include <grid.h>
+#include <flowfield.h>
+#include <arena.h>
+#include <aischeduler.h>
+#include <physicsstep.h>
+#include <floormesh.h>
+#include <renderbatch.h>
+#include <interpolator.h>
 #include <ae/program.h>
 #include <packet.h>
 #include <scripting.h>
@@ -55,18 +63,26 @@
 #include <iomanip>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 
 // Initialize
 _Map::_Map() :
 	Filename(""),
 	TileAtlas(nullptr),
 	Grid(nullptr),
+	AiScheduler(nullptr),
+	PhysicsStep(nullptr),
 	Stats(nullptr),
+	Interpolator(nullptr),
 	Scripting(nullptr),
-	TileVertexBufferID(0),
-	TileElementBufferID(0),
-	TileVertices(nullptr),
-	TileFaces(nullptr),
+	StringTable(nullptr),
+	SkippedSnapshotCount(0),
+	OnDamageReference(LUA_NOREF),
+	OnDeathReference(LUA_NOREF),
+	ScriptEventCount(0),
+	ScriptEventTime(0.0),
+	FloorMesh(nullptr),
+	RenderBatch(nullptr),
 	Camera(nullptr),
 	ObjectUpdateCount(0) {
 
@@ -77,7 +93,7 @@ _Map::_Map() :
 }
 
 // Initialize
-void _Map::Load(const std::string &Path, const _Stats *Stats, ae::_Manager<_Object> *ObjectManager, ae::_ServerNetwork *ServerNetwork) {
+void _Map::Load(const std::string &Path, const _Stats *Stats, ae::_Manager<_Object> *ObjectManager, _ServerTransport *ServerNetwork) {
 	this->Stats = Stats;
 	this->Filename = _Map::FixFilename(Path);
 	this->ServerNetwork = ServerNetwork;
@@ -87,6 +103,12 @@ void _Map::Load(const std::string &Path, const _Stats *Stats, ae::_Manager<_Obje
 	// Create uniform grid
 	Grid = new _Grid();
 
+	// Create ai scheduler and physics step on server
+	if(ServerNetwork) {
+		AiScheduler = new _AiScheduler();
+		PhysicsStep = new _PhysicsStep();
+	}
+
 	// Load file
 	gzifstream File(("maps/" + Filename).c_str());
 	try {
@@ -194,6 +216,21 @@ void _Map::Load(const std::string &Path, const _Stats *Stats, ae::_Manager<_Obje
 							Zone->OnEnter = OnEnter;
 						}
 					} break;
+					// Zone OnLeave
+					case 'l': {
+						if(!ObjectManager) {
+							File.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+							break;
+						}
+
+						File.ignore(1);
+						std::string OnLeave;
+						getline(File, OnLeave);
+						if(Object->HasComponent("zone")) {
+							_Zone *Zone = (_Zone *)(Object->Components["zone"]);
+							Zone->OnLeave = OnLeave;
+						}
+					} break;
 				}
 			}
 
@@ -214,33 +251,26 @@ void _Map::Load(const std::string &Path, const _Stats *Stats, ae::_Manager<_Obje
 	Scripting = new _Scripting();
 	Scripting->LoadScript("scripts/default.lua");
 
+	// Compile zone callbacks
+	for(auto &Zone : Zones)
+		CompileZone(Zone);
+
+	// Get event handlers
+	OnDamageReference = Scripting->GetFunctionReference("on_damage");
+	OnDeathReference = Scripting->GetFunctionReference("on_death");
+
 	// Initialize 2d tile rendering
 	if(!ServerNetwork) {
 		TileAtlas = new ae::_Atlas(ae::Assets.Textures[AtlasPath], glm::ivec2(64, 64), 1);
 
-		GLuint TileVertexCount = 4 * Grid->Size.x * Grid->Size.y;
-		GLuint TileFaceCount = 2 * Grid->Size.x * Grid->Size.y;
-
-		TileVertices = new glm::vec4[TileVertexCount];
-		TileFaces = new glm::u32vec3[TileFaceCount];
+		// Look up texture coordinates for every tile in the atlas once
+		std::vector<glm::vec4> TileTextureCoords(TileAtlas->Texture->Size.x * TileAtlas->Texture->Size.y / (TileAtlas->Size.x * TileAtlas->Size.y));
+		for(size_t i = 0; i < TileTextureCoords.size(); i++)
+			TileTextureCoords[i] = TileAtlas->GetTextureCoords((uint32_t)i);
 
-		int FaceIndex = 0;
-		int VertexIndex = 0;
-		for(int j = 0; j < Grid->Size.y; j++) {
-			for(int i = 0; i < Grid->Size.x; i++) {
-				TileFaces[FaceIndex++] = { VertexIndex + 2, VertexIndex + 1, VertexIndex + 0 };
-				TileFaces[FaceIndex++] = { VertexIndex + 2, VertexIndex + 3, VertexIndex + 1 };
-				VertexIndex += 4;
-			}
-		}
-
-		glGenBuffers(1, &TileVertexBufferID);
-		glBindBuffer(GL_ARRAY_BUFFER, TileVertexBufferID);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec4) * TileVertexCount, nullptr, GL_DYNAMIC_DRAW);
-
-		glGenBuffers(1, &TileElementBufferID);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, TileElementBufferID);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(glm::u32vec3) * TileFaceCount, nullptr, GL_DYNAMIC_DRAW);
+		FloorMesh = new _FloorMesh(Grid, TileTextureCoords);
+		RenderBatch = new _RenderBatch();
+		Interpolator = new _Interpolator();
 	}
 
 }
@@ -248,19 +278,30 @@ void _Map::Load(const std::string &Path, const _Stats *Stats, ae::_Manager<_Obje
 // Shut down
 _Map::~_Map() {
 	if(!ServerNetwork) {
+		delete FloorMesh;
+		delete RenderBatch;
+		delete Interpolator;
 		delete TileAtlas;
-		delete[] TileVertices;
-		delete[] TileFaces;
-		glDeleteBuffers(1, &TileVertexBufferID);
-		glDeleteBuffers(1, &TileElementBufferID);
 	}
 
 	// Remove objects
 	for(auto &Object : Objects) {
 		Grid->RemoveObject(Object);
+		Object->Handle = _Handle();
+		Object->MapIndex = -1;
+		Object->ActiveIndex = -1;
+		Object->ShapelessIndex = -1;
 		Object->Map = nullptr;
 	}
+	for(auto &Zone : Zones)
+		Zone->ZoneIndex = -1;
 
+	// Remove flow fields
+	for(auto &FlowField : FlowFields)
+		delete FlowField.second;
+
+	delete AiScheduler;
+	delete PhysicsStep;
 	delete Grid;
 	delete Scripting;
 }
@@ -297,6 +338,8 @@ bool _Map::Save(const std::string &Path) {
 			_Zone *Zone = (_Zone *)(Object->Components["zone"]);
 			if(Zone->OnEnter != "")
 				Output << "e " << Zone->OnEnter << "\n";
+			if(Zone->OnLeave != "")
+				Output << "l " << Zone->OnLeave << "\n";
 		}
 	}
 
@@ -315,19 +358,30 @@ bool _Map::Save(const std::string &Path) {
 }
 
 // Returns all the objects that fall inside the rectangle
-void _Map::GetSelectedObjects(const glm::vec4 &AABB, std::list<_Object *> &SelectedObjects) {
+void _Map::GetSelectedObjects(const glm::vec4 &AABB, _ArenaVector<_Object *> &SelectedObjects) {
 
 	for(auto &Object : Objects) {
 		if(!Object->Render || !Object->Physics || !Object->Shape)
 			continue;
 
 		if(Object->CheckAABB(AABB))
-			SelectedObjects.push_back(Object);
+			SelectedObjects.PushBack(Object);
 	}
 }
 
 // Return all objects that are a certain distance from a position
-void _Map::QueryObjects(const glm::vec2 &Position, float Radius, std::list<_Object *> &QueriedObjects) {
+void _Map::QueryObjects(const glm::vec2 &Position, float Radius, _ArenaVector<_Object *> &QueriedObjects) {
+	glm::vec4 AABB(Position.x - Radius, Position.y - Radius, Position.x + Radius, Position.y + Radius);
+
+	// Get candidates from grid
+	_ArenaVector<_Object *> Candidates(FrameArena);
+	Grid->QueryObjects(AABB, Candidates);
+
+	// Filter by distance
+	for(auto &Object : Candidates) {
+		if(glm::distance2(glm::vec2(Object->Physics->Position), Position) <= Radius * Radius)
+			QueriedObjects.PushBack(Object);
+	}
 }
 
 // Returns a starting position by level and player id
@@ -369,7 +423,7 @@ void _Map::HighlightBlocks() {
 
 // Render the floor
 void _Map::RenderFloors() {
-	if(!Camera || !TileVertices || !TileFaces)
+	if(!Camera || !FloorMesh)
 		return;
 
 	ae::Graphics.SetProgram(ae::Assets.Programs["pos_uv"]);
@@ -377,66 +431,76 @@ void _Map::RenderFloors() {
 	glUniformMatrix4fv(ae::Assets.Programs["pos_uv"]->TextureTransformID, 1, GL_FALSE, glm::value_ptr(glm::mat4(1)));
 	ae::Graphics.SetColor(glm::vec4(1.0f));
 
-	int VertexIndex = 0;
-	int FaceIndex = 0;
-	glm::vec4 Bounds = Camera->GetAABB();
-	Bounds[0] = glm::clamp(Bounds[0], 0.0f, (float)Grid->Size.x);
-	Bounds[1] = glm::clamp(Bounds[1], 0.0f, (float)Grid->Size.y);
-	Bounds[2] = glm::clamp(Bounds[2], 0.0f, (float)Grid->Size.x);
-	Bounds[3] = glm::clamp(Bounds[3], 0.0f, (float)Grid->Size.y);
-	for(int j = Bounds[1]; j < Bounds[3]; j++) {
-		for(int i = Bounds[0]; i < Bounds[2]; i++) {
-			glm::vec4 TextureCoords = TileAtlas->GetTextureCoords(Grid->Tiles[i][j].TextureIndex);
-			TileVertices[VertexIndex++] = { i + 0.0f, j + 0.0f, TextureCoords[0], TextureCoords[1] };
-			TileVertices[VertexIndex++] = { i + 1.0f, j + 0.0f, TextureCoords[2], TextureCoords[1] };
-			TileVertices[VertexIndex++] = { i + 0.0f, j + 1.0f, TextureCoords[0], TextureCoords[3] };
-			TileVertices[VertexIndex++] = { i + 1.0f, j + 1.0f, TextureCoords[2], TextureCoords[3] };
-
-			FaceIndex += 2;
-		}
-	}
-
-	GLsizeiptr VertexBufferSize = VertexIndex * sizeof(glm::vec4);
-	GLsizeiptr ElementBufferSize = FaceIndex * sizeof(glm::u32vec3);
+	// Rebuild edited chunks in view
+	FloorMesh->SelectChunks(Camera->GetAABB());
+	FloorMesh->BuildChunks();
 
 	glBindTexture(GL_TEXTURE_2D, TileAtlas->Texture->ID);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-
-	glBindBuffer(GL_ARRAY_BUFFER, TileVertexBufferID);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, VertexBufferSize, TileVertices);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)sizeof(glm::vec2));
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, TileElementBufferID);
-	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, ElementBufferSize, TileFaces);
-	glDrawElements(GL_TRIANGLES, FaceIndex * 3, GL_UNSIGNED_INT, 0);
+	FloorMesh->Render();
 
 	ae::Graphics.ResetState();
 }
 
+// Get the time remote objects are drawn at
+uint16_t _Map::GetRenderTime(uint16_t TimeSteps) const {
+	if(!Interpolator)
+		return uint16_t(TimeSteps - NETWORK_INTERP_DELAY);
+
+	return Interpolator->GetRenderTime(TimeSteps);
+}
+
+// Get number of draw calls issued by the last RenderObjects
+int _Map::GetDrawCallCount() const {
+	if(!RenderBatch)
+		return 0;
+
+	return RenderBatch->DrawCalls;
+}
+
+// Change a floor tile and rebuild its chunk on the next render
+void _Map::SetTileTexture(const glm::ivec2 &Coord, uint32_t TextureIndex) {
+	Grid->Tiles[Coord.x][Coord.y].TextureIndex = TextureIndex;
+	if(FloorMesh)
+		FloorMesh->Invalidate(Coord);
+}
+
 // Render objects
 void _Map::RenderObjects(double BlendFactor, bool EditorOnly) {
+	if(!RenderBatch || !Camera)
+		return;
+
 	for(size_t i = 0; i < RenderList.size(); i++)
 		RenderList[i].Objects.clear();
 
-	// Build render list
-	int Count = 0;
-	for(auto &Object : Objects) {
-		if(Object->Render && Camera && Object->CheckAABB(Camera->GetAABB())) {
+	// Find objects in view through the collision grid
+	_ArenaVector<_Object *> VisibleObjects(FrameArena);
+	Grid->QueryObjects(Camera->GetAABB(), VisibleObjects);
+	for(auto &Object : VisibleObjects) {
+		if(Object->Render)
 			RenderList[Object->Render->Stats->Layer].Objects.push_back(Object);
-			Count++;
-		}
 	}
 
+	// Objects without shapes aren't in the grid and are always drawn
+	for(auto &Object : ShapelessRenderObjects)
+		RenderList[Object->Render->Stats->Layer].Objects.push_back(Object);
+
 	// Render all the objects in each render list
+	RenderBatch->ResetStats();
 	for(size_t i = 0; i < RenderList.size(); i++) {
 		if(EditorOnly || (!EditorOnly && !RenderList[i].Layer->EditorOnly)) {
 			ae::Graphics.SetDepthTest(RenderList[i].Layer->DepthTest);
 			ae::Graphics.SetDepthMask(RenderList[i].Layer->DepthMask);
 
-			// Draw objects
+			// Draw objects grouped by program, texture and mesh, layers without depth testing keep their draw order
+			RenderBatch->Clear();
 			for(auto &Iterator : RenderList[i].Objects)
-				Iterator->Render->Draw3D(BlendFactor);
+				Iterator->Render->AddDrawItems(*RenderBatch, BlendFactor);
+			RenderBatch->Build(RenderList[i].Layer->DepthTest);
+			RenderBatch->Submit();
+
+			// Draw debug text
+			for(auto &Iterator : RenderList[i].Objects)
+				Iterator->Render->DrawDebug();
 		}
 	}
 
@@ -446,6 +510,134 @@ void _Map::RenderObjects(double BlendFactor, bool EditorOnly) {
 
 // Update map
 void _Map::Update(double FrameTime) {
+
+	// Free callbacks of zones removed since the last update
+	ReleaseScriptReferences();
+
+	// Queue exit events for objects that left zones
+	UpdateZones();
+
+	// Free flow fields that no longer have followers
+	for(auto Iterator = FlowFields.begin(); Iterator != FlowFields.end(); ) {
+		_FlowField *FlowField = Iterator->second;
+		FlowField->IdleTicks++;
+		if(FlowField->IdleTicks > AI_FLOWFIELD_IDLE_TICKS) {
+			delete FlowField;
+			Iterator = FlowFields.erase(Iterator);
+		}
+		else
+			++Iterator;
+	}
+}
+
+// Run a two phase physics step for objects that aren't driven by player input
+void _Map::UpdatePhysics(double FrameTime) {
+	if(!PhysicsStep)
+		return;
+
+	// Gather active bodies in list order
+	PhysicsStep->Bodies.clear();
+	for(auto &Object : ActiveObjects) {
+		if(Object->Physics && !Object->Peer && !Object->Deleted)
+			PhysicsStep->Bodies.push_back(Object->Physics);
+	}
+
+	PhysicsStep->Detect(Grid);
+	PhysicsStep->Resolve(Grid);
+}
+
+// Compile zone callbacks into lua functions
+void _Map::CompileZone(_Zone *Zone) {
+	Zone->OnEnterReference = Scripting->CompileLua(Zone->OnEnter);
+	Zone->OnLeaveReference = Scripting->CompileLua(Zone->OnLeave);
+}
+
+// Add an object to a zone and queue the enter callback if it wasn't already inside
+void _Map::EnterZone(_Zone *Zone, _Object *Object) {
+	if(!Zone->AddOccupant(Object))
+		return;
+
+	QueueScriptEvent(Zone->OnEnterReference, Object, nullptr, 0);
+}
+
+// Remove objects that no longer overlap their zones, objects that left the map are dropped without an event
+void _Map::UpdateZones() {
+	for(auto &Zone : Zones) {
+		for(size_t i = 0; i < Zone->Occupants.size(); ) {
+			_Object *Object = GetObject(Zone->Occupants[i]);
+			if(Object && Zone->Contains(Object)) {
+				i++;
+				continue;
+			}
+
+			Zone->Occupants[i] = Zone->Occupants.back();
+			Zone->Occupants.pop_back();
+			if(Object)
+				QueueScriptEvent(Zone->OnLeaveReference, Object, nullptr, 0);
+		}
+	}
+}
+
+// Release compiled callbacks of removed zones and drop events still queued for them
+void _Map::ReleaseScriptReferences() {
+	if(ReleasedScriptReferences.empty())
+		return;
+
+	ScriptEvents.erase(std::remove_if(ScriptEvents.begin(), ScriptEvents.end(), [this](const _ScriptEvent &Event) {
+		return std::find(ReleasedScriptReferences.begin(), ReleasedScriptReferences.end(), Event.Reference) != ReleasedScriptReferences.end();
+	}), ScriptEvents.end());
+
+	for(auto Reference : ReleasedScriptReferences)
+		Scripting->ReleaseLua(Reference);
+	ReleasedScriptReferences.clear();
+}
+
+// Queue a script call to run when the map dispatches events
+void _Map::QueueScriptEvent(int Reference, const _Object *Object, const _Object *Other, int Value) {
+	if(Reference == LUA_NOREF)
+		return;
+
+	_ScriptEvent Event;
+	Event.Reference = Reference;
+	Event.Object = Object->Handle;
+
+	// Handles only resolve in the map that created them
+	if(Other && Other->Map == this)
+		Event.Other = Other->Handle;
+	Event.Value = Value;
+	ScriptEvents.push_back(Event);
+}
+
+// Run all script events queued during the simulation
+void _Map::DispatchScriptEvents() {
+	auto StartTime = std::chrono::steady_clock::now();
+
+	// Events queued by scripts run next tick
+	DispatchedScriptEvents.swap(ScriptEvents);
+	for(auto &Event : DispatchedScriptEvents)
+		Scripting->ExecuteEvent(Event, this);
+
+	ScriptEventCount = (int)DispatchedScriptEvents.size();
+	ScriptEventTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+	DispatchedScriptEvents.clear();
+}
+
+// Get the shared flow field leading to a target, rebuilding it when the target changes tiles
+_FlowField *_Map::GetFlowField(const _Object *Target) {
+	if(!Target->Physics)
+		return nullptr;
+
+	_FlowField *&FlowField = FlowFields[Target];
+	if(!FlowField)
+		FlowField = new _FlowField(Grid);
+
+	glm::ivec2 Goal = Grid->GetValidCoord(glm::ivec2(Target->Physics->Position));
+	if(Goal != FlowField->Goal)
+		FlowField->Build(Goal, AI_FLOWFIELD_RADIUS);
+
+	FlowField->IdleTicks = 0;
+
+	return FlowField;
 }
 
 // Add object to map and notify peers
@@ -464,22 +656,59 @@ void _Map::AddObject(_Object *Object) {
 		BroadcastPacket(Packet, ae::_Network::RELIABLE);
 	}
 
+	// Schedule ai
+	if(AiScheduler && Object->HasComponent("ai"))
+		AiScheduler->AddAgent((_Ai *)(Object->Components["ai"]));
+
+	// Track zones
+	if(Object->HasComponent("zone")) {
+		_Zone *Zone = (_Zone *)(Object->Components["zone"]);
+		Zone->ZoneIndex = (int)Zones.size();
+		Zones.push_back(Zone);
+		if(Scripting)
+			CompileZone(Zone);
+	}
+
+	// Let the map step physics for everything but players
+	if(PhysicsStep && Object->Physics && !Object->Peer)
+		Object->Physics->UpdateAutomatically = false;
+
+	// Track objects the grid can't cull
+	if(Object->Render && !Object->Shape) {
+		Object->ShapelessIndex = (int)ShapelessRenderObjects.size();
+		ShapelessRenderObjects.push_back(Object);
+	}
+
 	// Add to list
+	Object->Handle = Handles.Create(Object);
+	Object->MapIndex = (int)Objects.size();
 	Objects.push_back(Object);
+	UpdateActiveObject(Object);
 }
 
-// Removes an object from the object list and collision grid
-void _Map::RemoveObject(_Object *Object) {
+// Add or remove an object from the active list after its activity changes
+void _Map::UpdateActiveObject(_Object *Object) {
+	bool Listed = Object->ActiveIndex >= 0;
+	if(Object->IsActive() && Object->Map == this) {
+		if(Listed)
+			return;
 
-	// Remove pointers to deleted object from other objects
-	for(auto &QueryObject : Objects) {
-		if(QueryObject->HasComponent("ai")) {
-			_Ai *Ai = (_Ai *)(QueryObject->Components["ai"]);
-			if(Ai->Target == Object) {
-				Ai->Target = nullptr;
-			}
-		}
+		Object->ActiveIndex = (int)ActiveObjects.size();
+		ActiveObjects.push_back(Object);
+	}
+	else if(Listed) {
+
+		// Swap with the last active object and pop
+		_Object *LastObject = ActiveObjects.back();
+		ActiveObjects[Object->ActiveIndex] = LastObject;
+		LastObject->ActiveIndex = Object->ActiveIndex;
+		ActiveObjects.pop_back();
+		Object->ActiveIndex = -1;
 	}
+}
+
+// Removes an object from the object list and collision grid
+void _Map::RemoveObject(_Object *Object) {
 
 	// Notify peers
 	if(ServerNetwork) {
@@ -494,33 +723,137 @@ void _Map::RemoveObject(_Object *Object) {
 		BroadcastPacket(Packet, ae::_Network::RELIABLE);
 	}
 
-	// Remove object
+	// Stop scheduling ai
+	if(AiScheduler && Object->HasComponent("ai"))
+		AiScheduler->RemoveAgent((_Ai *)(Object->Components["ai"]));
+
+	// Stop tracking zone, other zones drop the object when they next update
+	if(Object->HasComponent("zone")) {
+		_Zone *Zone = (_Zone *)(Object->Components["zone"]);
+		if(Zone->ZoneIndex >= 0) {
+
+			// Queued events may still call the callbacks, so free them on the next update
+			if(Scripting) {
+				ReleasedScriptReferences.push_back(Zone->OnEnterReference);
+				ReleasedScriptReferences.push_back(Zone->OnLeaveReference);
+			}
+			Zone->OnEnterReference = Zone->OnLeaveReference = LUA_NOREF;
+			Zone->Occupants.clear();
+
+			// Swap with the last zone and pop
+			_Zone *LastZone = Zones.back();
+			Zones[Zone->ZoneIndex] = LastZone;
+			LastZone->ZoneIndex = Zone->ZoneIndex;
+			Zones.pop_back();
+			Zone->ZoneIndex = -1;
+		}
+	}
+
+	// Remove flow field leading to object
+	auto FlowFieldIterator = FlowFields.find(Object);
+	if(FlowFieldIterator != FlowFields.end()) {
+		delete FlowFieldIterator->second;
+		FlowFields.erase(FlowFieldIterator);
+	}
+
+	// Stop drawing
+	if(Object->ShapelessIndex >= 0) {
+		_Object *LastObject = ShapelessRenderObjects.back();
+		ShapelessRenderObjects[Object->ShapelessIndex] = LastObject;
+		LastObject->ShapelessIndex = Object->ShapelessIndex;
+		ShapelessRenderObjects.pop_back();
+		Object->ShapelessIndex = -1;
+	}
+
+	// Swap with the last object and pop
+	if(Object->MapIndex >= 0 && Object->MapIndex < (int)Objects.size() && Objects[Object->MapIndex] == Object) {
+		_Object *LastObject = Objects.back();
+		Objects[Object->MapIndex] = LastObject;
+		LastObject->MapIndex = Object->MapIndex;
+		Objects.pop_back();
+	}
+	Handles.Release(Object->Handle);
+	Object->Handle = _Handle();
+	Object->MapIndex = -1;
 	Object->Map = nullptr;
-	auto Iterator = std::find(Objects.begin(), Objects.end(), Object);
-	if(Iterator != Objects.end())
-		Objects.erase(Iterator);
+	UpdateActiveObject(Object);
 
 	// Remove from collision grid
 	Grid->RemoveObject(Object);
 }
 
-// Broadcast a packet to all peers in the map
+// Queue an object to be removed at the end of the tick
+void _Map::DestroyObject(_Object *Object) {
+	if(Object->PendingDelete || Object->Deleted)
+		return;
+
+	// Clients and the editor don't defer
+	if(!ServerNetwork) {
+		Object->Deleted = true;
+		return;
+	}
+
+	Object->PendingDelete = true;
+	DestroyQueue.push_back(Object->Handle);
+}
+
+// Remove queued objects from the map and hand them back to the object manager
+void _Map::DestroyQueuedObjects() {
+	if(DestroyQueue.empty())
+		return;
+
+	// Objects removed some other way since being queued no longer resolve
+	std::vector<_Handle> Destroyed;
+	Destroyed.swap(DestroyQueue);
+	for(auto &Handle : Destroyed) {
+		_Object *Object = Handles.Get(Handle);
+		if(!Object)
+			continue;
+
+		RemoveObject(Object);
+		Object->Deleted = true;
+	}
+}
+
+// Resolve a handle to an object in this map
+_Object *_Map::GetObject(const _Handle &Handle) const {
+	_Object *Object = Handles.Get(Handle);
+	if(!Object || Object->PendingDelete)
+		return nullptr;
+
+	return Object;
+}
+
+// Broadcast a packet to all peers in the map, the network shares one copy between them
 void _Map::BroadcastPacket(ae::_Buffer &Buffer, ae::_Network::SendType Type) {
 	if(!ServerNetwork)
 		return;
 
-	for(auto &Peer : Peers)
-		ServerNetwork->SendPacket(Buffer, Peer, Type, Type == ae::_Network::UNSEQUENCED);
+	ServerNetwork->BroadcastPacket(Buffer, Peers, Type, Type == ae::_Network::UNSEQUENCED);
 }
 
-// Remove a peer
+// Add a peer
+void _Map::AddPeer(const ae::_Peer *Peer) {
+	if(PeerIndices.find(Peer) != PeerIndices.end())
+		return;
+
+	PeerIndices[Peer] = Peers.size();
+	Peers.push_back(Peer);
+}
+
+// Remove a peer by swapping the last one into its slot
 void _Map::RemovePeer(const ae::_Peer *Peer) {
-	for(auto Iterator = Peers.begin(); Iterator != Peers.end(); ++Iterator) {
-		if(*Iterator == Peer) {
-			Peers.erase(Iterator);
-			return;
-		}
+	auto Iterator = PeerIndices.find(Peer);
+	if(Iterator == PeerIndices.end())
+		return;
+
+	size_t Index = Iterator->second;
+	PeerIndices.erase(Iterator);
+	if(Index != Peers.size() - 1) {
+		Peers[Index] = Peers.back();
+		PeerIndices[Peers[Index]] = Index;
 	}
+	Peers.pop_back();
 }
 
 // Add proper extensions to filename
@@ -535,24 +868,34 @@ std::string _Map::FixFilename(const std::string &Filename) {
 }
 
 // Send the object list to a peer
-void _Map::SendObjectList(_Object *Player, uint16_t TimeSteps) {
+size_t _Map::SendObjectList(_Object *Player, uint16_t TimeSteps) {
 	const ae::_Peer *Peer = Player->Peer;
 	if(!Peer)
-		return;
+		return 0;
 
-	// Create packet
-	ae::_Buffer Packet;
-	Packet.Write<char>(Packet::OBJECT_LIST);
-	Packet.Write<uint16_t>(TimeSteps);
-	Packet.Write<ae::NetworkIDType>(Peer->Object->NetworkID);
+	// Stream the list in chunks so joining a busy map doesn't need one huge packet
+	size_t BytesSent = 0;
+	size_t Start = 0;
+	do {
+		size_t Count = std::min(Objects.size() - Start, NETWORK_OBJECT_LIST_CHUNK);
 
-	// Add place holder for object size
-	Packet.Write<ae::NetworkIDType>((ae::NetworkIDType)Objects.size());
-	for(auto &Object : Objects) {
-		Object->NetworkSerialize(Packet);
-	}
+		// Create packet
+		ae::_Buffer Packet;
+		Packet.Write<char>(Packet::OBJECT_LIST);
+		Packet.Write<uint16_t>(TimeSteps);
+		Packet.Write<ae::NetworkIDType>(Peer->Object->NetworkID);
+		Packet.Write<char>(Start == 0);
+
+		Packet.Write<ae::NetworkIDType>((ae::NetworkIDType)Count);
+		for(size_t i = Start; i < Start + Count; i++)
+			Objects[i]->NetworkSerialize(Packet);
+
+		BytesSent += Packet.GetCurrentSize();
+		ServerNetwork->SendPacket(Packet, Peer);
+		Start += Count;
+	} while(Start < Objects.size());
 
-	ServerNetwork->SendPacket(Packet, Peer);
+	return BytesSent;
 }
 
 // Build object update packet for the map
@@ -564,12 +907,15 @@ void _Map::SendObjectUpdates(uint16_t TimeSteps) {
 	Packet.Write<ae::NetworkIDType>(NetworkID);
 	Packet.Write<uint16_t>(TimeSteps);
 
+	// Only active objects can change
+	SkippedSnapshotCount = (int)(Objects.size() - ActiveObjects.size());
+
 	// Write object count
-	Packet.Write<ae::NetworkIDType>((ae::NetworkIDType)Objects.size());
+	Packet.Write<ae::NetworkIDType>((ae::NetworkIDType)ActiveObjects.size());
 
 	// Iterate over objects
 	int Count = 0;
-	for(auto &Object : Objects) {
+	for(auto &Object : ActiveObjects) {
 		//if(Object->SendUpdate) {
 			Object->NetworkSerializeUpdate(Packet, TimeSteps);
 			Object->SendUpdate = false;
@@ -583,3 +929,84 @@ void _Map::SendObjectUpdates(uint16_t TimeSteps) {
 	//if(Count != ObjectUpdateCount)
 	//	throw std::runtime_error("Update count mismatch: " + std::to_string(Count) + " vs " + std::to_string(ObjectUpdateCount));
 }
+
+// FNV-1a over a block of bytes
+static uint64_t HashData(uint64_t Hash, const void *Data, size_t Size) {
+	const uint8_t *Bytes = (const uint8_t *)Data;
+	for(size_t i = 0; i < Size; i++) {
+		Hash ^= Bytes[i];
+		Hash *= 0x100000001b3ull;
+	}
+
+	return Hash;
+}
+
+// Checksum positions, velocities, health and ai targets in network id order
+uint64_t _Map::HashState(std::vector<_ObjectHash> *ObjectHashes) const {
+
+	// Simulation state gathered into a compact array
+	struct _ObjectState {
+		ae::NetworkIDType NetworkID;
+		ae::NetworkIDType TargetID;
+		int HasTarget;
+		int Health;
+		glm::vec3 Position;
+		glm::vec3 Velocity;
+	};
+
+	_ArenaVector<_ObjectState> States(FrameArena, Objects.size() + 1);
+	for(const auto &Object : Objects) {
+		_ObjectState State;
+		State.NetworkID = Object->NetworkID;
+		State.TargetID = 0;
+		State.HasTarget = 0;
+		State.Health = 0;
+		State.Position = glm::vec3(0.0f);
+		State.Velocity = glm::vec3(0.0f);
+		if(Object->Physics) {
+			State.Position = Object->Physics->Position;
+			State.Velocity = Object->Physics->Velocity;
+		}
+
+		auto Iterator = Object->Components.find("health");
+		if(Iterator != Object->Components.end())
+			State.Health = ((_Health *)Iterator->second)->Health;
+
+		Iterator = Object->Components.find("ai");
+		if(Iterator != Object->Components.end()) {
+			const _Object *Target = GetObject(((const _Ai *)Iterator->second)->GetTargetHandle());
+			if(Target) {
+				State.TargetID = Target->NetworkID;
+				State.HasTarget = 1;
+			}
+		}
+
+		States.PushBack(State);
+	}
+
+	// Order by network id so the result doesn't depend on container order
+	std::sort(States.begin(), States.end(), [](const _ObjectState &A, const _ObjectState &B) {
+		return A.NetworkID < B.NetworkID;
+	});
+
+	if(ObjectHashes)
+		ObjectHashes->clear();
+
+	// Hash fields individually so padding never leaks in
+	uint64_t Hash = 0xcbf29ce484222325ull;
+	for(const auto &State : States) {
+		uint64_t ObjectHash = 0xcbf29ce484222325ull;
+		ObjectHash = HashData(ObjectHash, &State.NetworkID, sizeof(State.NetworkID));
+		ObjectHash = HashData(ObjectHash, &State.Position[0], sizeof(float) * 3);
+		ObjectHash = HashData(ObjectHash, &State.Velocity[0], sizeof(float) * 3);
+		ObjectHash = HashData(ObjectHash, &State.Health, sizeof(State.Health));
+		ObjectHash = HashData(ObjectHash, &State.HasTarget, sizeof(State.HasTarget));
+		ObjectHash = HashData(ObjectHash, &State.TargetID, sizeof(State.TargetID));
+		Hash = HashData(Hash, &ObjectHash, sizeof(ObjectHash));
+
+		if(ObjectHashes)
+			ObjectHashes->push_back({ State.NetworkID, ObjectHash, glm::vec2(State.Position) });
+	}
+
+	return Hash;
+}
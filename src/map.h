@@ -18,6 +18,7 @@
 #pragma once
 
 // Libraries
+#include <handle.h>
 #include <ae/network.h>
 #include <ae/type.h>
 #include <ae/baseobject.h>
@@ -38,10 +39,19 @@ class _Scripting;
 class _Server;
 class _Stats;
 class _Grid;
+class _FlowField;
+template<class T> class _ArenaVector;
+class _AiScheduler;
+class _PhysicsStep;
+class _Zone;
+class _StringTable;
+class _FloorMesh;
+class _RenderBatch;
+class _Interpolator;
+class _ServerTransport;
 
 namespace ae {
 	template<class T> class _Manager;
-	class _ServerNetwork;
 	class _Atlas;
 	class _Camera;
 	class _Texture;
@@ -65,8 +75,23 @@ struct _Impact {
 	int Type;
 };
 
+// Script call queued during the simulation, objects are referenced by handles into the map
+struct _ScriptEvent {
+	int Reference;
+	_Handle Object;
+	_Handle Other;
+	int Value;
+};
+
+// Checksum of one object's simulation state
+struct _ObjectHash {
+	ae::NetworkIDType NetworkID;
+	uint64_t Hash;
+	glm::vec2 Position;
+};
+
 struct _RenderList {
-	std::list<_Object *> Objects;
+	std::vector<_Object *> Objects;
 	const ae::_Layer *Layer;
 };
 
@@ -79,12 +104,14 @@ class _Map : public ae::_BaseObject {
 		~_Map();
 
 		bool Save(const std::string &Path);
-		void Load(const std::string &Path, const _Stats *Stats, ae::_Manager<_Object> *ObjectManager, ae::_ServerNetwork *ServerNetwork=nullptr);
+		void Load(const std::string &Path, const _Stats *Stats, ae::_Manager<_Object> *ObjectManager, _ServerTransport *ServerNetwork=nullptr);
 
 		void Update(double FrameTime);
+		void UpdatePhysics(double FrameTime);
 
 		void SetCamera(ae::_Camera *Camera) { this->Camera = Camera; }
 		void RenderFloors();
+		void SetTileTexture(const glm::ivec2 &Coord, uint32_t TextureIndex);
 		void RenderObjects(double BlendFactor, bool EditorOnly);
 		void RenderGrid(int Spacing);
 		void HighlightBlocks();
@@ -95,16 +122,32 @@ class _Map : public ae::_BaseObject {
 		// Objects
 		void AddObject(_Object *Object);
 		void RemoveObject(_Object *Object);
+		void DestroyObject(_Object *Object);
+		void DestroyQueuedObjects();
+		_Object *GetObject(const _Handle &Handle) const;
 		void BroadcastPacket(ae::_Buffer &Buffer, ae::_Network::SendType Type=ae::_Network::RELIABLE);
-		void SendObjectList(_Object *Player, uint16_t TimeSteps);
+		size_t SendObjectList(_Object *Player, uint16_t TimeSteps);
 		void SendObjectUpdates(uint16_t TimeSteps);
-		void GetSelectedObjects(const glm::vec4 &AABB, std::list<_Object *> &SelectedObjects);
-		void QueryObjects(const glm::vec2 &Position, float Radius, std::list<_Object *> &QueriedObjects);
+		uint64_t HashState(std::vector<_ObjectHash> *ObjectHashes=nullptr) const;
+		void GetSelectedObjects(const glm::vec4 &AABB, _ArenaVector<_Object *> &SelectedObjects);
+		void QueryObjects(const glm::vec2 &Position, float Radius, _ArenaVector<_Object *> &QueriedObjects);
 		size_t GetObjectCount() { return Objects.size(); }
+		void UpdateActiveObject(_Object *Object);
+		int GetSkippedObjectCount() const { return (int)(Objects.size() - ActiveObjects.size()); }
+		int GetDrawCallCount() const;
+
+		// Zones
+		void EnterZone(_Zone *Zone, _Object *Object);
+
+		// Scripting events
+		void QueueScriptEvent(int Reference, const _Object *Object, const _Object *Other, int Value);
+		void DispatchScriptEvents();
+		int GetScriptEventCount() const { return ScriptEventCount; }
+		double GetScriptEventTime() const { return ScriptEventTime; }
 
 		// Network
-		const std::list<const ae::_Peer *> &GetPeers() const { return Peers; }
-		void AddPeer(const ae::_Peer *Peer) { Peers.push_back(Peer); }
+		const std::vector<const ae::_Peer *> &GetPeers() const { return Peers; }
+		void AddPeer(const ae::_Peer *Peer);
 		void RemovePeer(const ae::_Peer *Peer);
 
 		static std::string FixFilename(const std::string &Filename);
@@ -119,28 +162,71 @@ class _Map : public ae::_BaseObject {
 		// Collision
 		_Grid *Grid;
 
+		// Navigation
+		_FlowField *GetFlowField(const _Object *Target);
+
+		// Ai
+		_AiScheduler *AiScheduler;
+
+		// Physics
+		_PhysicsStep *PhysicsStep;
+
 		// Stats
 		const _Stats *Stats;
 
+		// Interpolation of remote objects on clients
+		_Interpolator *Interpolator;
+		uint16_t GetRenderTime(uint16_t TimeSteps) const;
+
 		// Scripting
 		_Scripting *Scripting;
 
+		// Network
+		const _StringTable *StringTable;
+
+		// Stats
+		int SkippedSnapshotCount;
+
+		// Script event handlers
+		int OnDamageReference;
+		int OnDeathReference;
+
 	private:
 
+		void CompileZone(_Zone *Zone);
+		void UpdateZones();
+		void ReleaseScriptReferences();
+
 		// Objects
-		std::list<_Object *> Objects;
+		std::vector<_Object *> Objects;
+		_HandlePool<_Object> Handles;
+		std::vector<_Object *> ActiveObjects;
+		std::vector<_Handle> DestroyQueue;
+
+		// Zones
+		std::vector<_Zone *> Zones;
+
+		// Scripting events
+		std::vector<_ScriptEvent> ScriptEvents;
+		std::vector<_ScriptEvent> DispatchedScriptEvents;
+		std::vector<int> ReleasedScriptReferences;
+		int ScriptEventCount;
+		double ScriptEventTime;
+
+		// Navigation
+		std::unordered_map<const _Object *, _FlowField *> FlowFields;
 
 		// Rendering
-		uint32_t TileVertexBufferID;
-		uint32_t TileElementBufferID;
-		glm::vec4 *TileVertices;
-		glm::u32vec3 *TileFaces;
+		_FloorMesh *FloorMesh;
+		_RenderBatch *RenderBatch;
+		std::vector<_Object *> ShapelessRenderObjects;
 
 		// Graphics
 		ae::_Camera *Camera;
 
 		// Network
-		ae::_ServerNetwork *ServerNetwork;
-		std::list<const ae::_Peer *> Peers;
+		_ServerTransport *ServerNetwork;
+		std::vector<const ae::_Peer *> Peers;
+		std::unordered_map<const ae::_Peer *, size_t> PeerIndices;
 		uint16_t ObjectUpdateCount;
 };
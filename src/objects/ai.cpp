@@ -21,6 +21,8 @@
 #include <stats.h>
 #include <ae/buffer.h>
 #include <map.h>
+#include <flowfield.h>
+#include <arena.h>
 #include <constants.h>
 #include <glm/gtx/norm.hpp>
 #include <iostream>
@@ -28,36 +30,47 @@
 // Constructor
 _Ai::_Ai(_Object *Parent, const _AiStat *Stat) :
 	_Component(Parent),
-	Target(nullptr),
+	SchedulerIndex(-1),
 	TargetTimer(0.0) {
 
+	// Thinking is run by the map's scheduler
+	UpdateAutomatically = false;
 }
 
 // Destructor
 _Ai::~_Ai() {
 }
 
-// Update
-void _Ai::Update(double FrameTime) {
+// Update movement and targeting
+void _Ai::Think(double FrameTime) {
 	if(!Parent->Server)
 		return;
 
 	_Physics *Physics = Parent->Physics;
-
-	//TODO fix
-	Parent->SendUpdate = true;
+	glm::vec3 LastVelocity = Physics->Velocity;
 
 	// Follow target
-	if(Target) {
-		Physics->Velocity = Target->Physics->Position - Physics->Position;
+	_Object *TargetObject = GetTarget();
+	if(TargetObject) {
+		Physics->Velocity = TargetObject->Physics->Position - Physics->Position;
+
+		// Steer along the flow field shared by everything chasing the target
+		glm::vec2 FlowDirection(0.0f);
+		if(Parent->Map) {
+			const _FlowField *FlowField = Parent->Map->GetFlowField(TargetObject);
+			if(FlowField)
+				FlowDirection = FlowField->GetDirection(glm::vec2(Physics->Position));
+		}
 
-		float TargetRadians = (Target->Physics->Rotation - 90) / (180.0f / MATH_PI);
+		float TargetRadians = (TargetObject->Physics->Rotation - 90) / (180.0f / MATH_PI);
 		glm::vec2 TargetDirection = glm::vec2(std::cos(TargetRadians), std::sin(TargetRadians));
 
 		if(glm::dot(glm::vec2(Physics->Velocity), TargetDirection) > 0) {
-			if(!(Physics->Velocity.x == 0.0f && Physics->Velocity.y == 0.0f)) {
+			if(!(FlowDirection.x == 0.0f && FlowDirection.y == 0.0f)) {
+				Physics->Velocity = glm::vec3(FlowDirection * 0.01f, 0.0f);
+			}
+			else if(!(Physics->Velocity.x == 0.0f && Physics->Velocity.y == 0.0f)) {
 				Physics->Velocity = glm::normalize(Physics->Velocity) * 0.01f;
-				Parent->SendUpdate = true;
 			}
 			//if(TimeSteps & 64) {
 				//Physics->Velocity = glm::vec3(0, 0, 0);
@@ -74,6 +87,33 @@ void _Ai::Update(double FrameTime) {
 
 		//std::cout << "TargetTimer=" << TargetTimer << std::endl;
 	}
+
+	// Only send updates when movement changes
+	if(Physics->Velocity != LastVelocity)
+		Parent->SendUpdate = true;
+
+	// Wake up to move
+	if(!(Physics->Velocity.x == 0.0f && Physics->Velocity.y == 0.0f))
+		Parent->Wake();
+}
+
+// Resolve the target handle, forgetting it once the object is gone or has left the map
+_Object *_Ai::GetTarget() {
+	if(!Target.IsValid())
+		return nullptr;
+
+	_Object *Object = nullptr;
+	if(Parent->Map)
+		Object = Parent->Map->GetObject(Target);
+	if(!Object)
+		Target = _Handle();
+
+	return Object;
+}
+
+// Remember target by handle
+void _Ai::SetTarget(const _Object *Object) {
+	Target = Object ? Object->Handle : _Handle();
 }
 
 // Serialize
@@ -90,13 +130,12 @@ void _Ai::FindTarget() {
 	TargetTimer = 0.0;
 	if(Parent->Map) {
 		_Physics *Physics = Parent->Physics;
-		glm::vec4 AABB(Physics->Position.x - 5, Physics->Position.y - 5, Physics->Position.x + 5, Physics->Position.y + 5);
-		std::list<_Object *> Objects;
-		Parent->Map->GetSelectedObjects(AABB, Objects);
+		_ArenaVector<_Object *> Objects(FrameArena);
+		Parent->Map->QueryObjects(glm::vec2(Physics->Position), 5.0f, Objects);
 		for(auto &Object : Objects) {
 			if(Object->Identifier == "player") {
 				//std::cout << "Found player" << std::endl;
-				Target = Object;
+				SetTarget(Object);
 				break;
 			}
 		}
@@ -19,6 +19,7 @@
 
 // Libraries
 #include <objects/component.h>
+#include <handle.h>
 
 // Forward Declarations
 struct _AiStat;
@@ -32,19 +33,26 @@ class _Ai : public _Component {
 		~_Ai();
 
 		// Updates
-		void Update(double FrameTime) override;
+		void Think(double FrameTime);
+		void Stagger(double Offset) { TargetTimer = Offset; }
 
 		// Network
 		void NetworkSerialize(ae::_Buffer &Buffer) override;
 		void NetworkUnserialize(ae::_Buffer &Buffer) override;
 
+		// Target
+		_Object *GetTarget();
+		const _Handle &GetTargetHandle() const { return Target; }
+		void SetTarget(const _Object *Object);
+
 		// Attributes
-		_Object *Target;
+		int SchedulerIndex;
 
 	private:
 
 		void FindTarget();
 
+		_Handle Target;
 		double TargetTimer;
 
 };
@@ -19,6 +19,7 @@
 #include <objects/object.h>
 #include <objects/physics.h>
 #include <objects/animation.h>
+#include <map.h>
 #include <ae/network.h>
 #include <constants.h>
 #include <stats.h>
@@ -97,28 +98,34 @@ void _Controller::HandleCursor(const glm::vec2 &Cursor) {
 	Parent->Physics->FacePosition(Cursor);
 }
 
-// Rewind the physics state and replay input
+// Rewind the physics state and replay input when the server disagrees with the prediction
 void _Controller::ReplayInput() {
+	_Physics *Physics = Parent->Physics;
 
-	// Find start time
-	int PredictionIndex = -1;
+	// Find the acknowledged input
+	int AckIndex = -1;
 	for(int i = 0; i < History.Size(); i++) {
-		const _Input &Input = History.Back(i);
-		if(Input.Time == LastInputTime) {
-			PredictionIndex = i-1;
+		if(History.Back(i).Time == LastInputTime) {
+			AckIndex = i;
 			break;
 		}
 	}
 
-	// Apply client correction
-	if(PredictionIndex >= 0) {
-		Parent->Physics->Position = Parent->Physics->NetworkPosition;
-		while(PredictionIndex >= 0) {
-			const _Input &Input = History.Back(PredictionIndex);
+	// Skip replay when the prediction for that tick was right
+	glm::vec2 Position(Physics->NetworkPosition);
+	if(AckIndex >= 0 && glm::distance2(History.Back(AckIndex).Position, Position) > NETWORK_PREDICTION_TOLERANCE * NETWORK_PREDICTION_TOLERANCE) {
+		History.Back(AckIndex).Position = Position;
+
+		// Replay from the server position without touching the grid, then move once
+		const _Grid *Grid = Parent->Map->Grid;
+		for(int i = AckIndex - 1; i >= 0; i--) {
+			_Input &Input = History.Back(i);
 			HandleInput(Input, true);
-			Parent->Physics->Update(GAME_TIMESTEP);
-			PredictionIndex--;
+			Physics->Predict(Grid, Position);
+			Input.Position = Position;
 		}
+
+		Physics->SetPosition(Position);
 	}
 
 	// Remove old inputs from send queue
@@ -33,10 +33,11 @@ class _Controller : public _Component {
 
 		struct _Input {
 			_Input() { }
-			_Input(uint16_t Time, uint8_t ActionState) : Time(Time), ActionState(ActionState) { }
+			_Input(uint16_t Time, uint8_t ActionState) : Time(Time), ActionState(ActionState), Position(0.0f) { }
 
 			uint16_t Time;
 			uint8_t ActionState;
+			glm::vec2 Position;
 		};
 
 		_Controller(_Object *Parent, const _ControllerStat *Stats);
@@ -23,10 +23,13 @@
 #include <objects/shape.h>
 #include <objects/shot.h>
 #include <map.h>
+#include <stringtable.h>
 #include <constants.h>
 #include <ae/buffer.h>
 #include <glm/gtx/norm.hpp>
+#include <glm/common.hpp>
 #include <iostream>
+#include <cmath>
 
 // Constructor
 _Object::_Object() :
@@ -34,15 +37,19 @@ _Object::_Object() :
 	Animation(nullptr),
 	Render(nullptr),
 	Shape(nullptr),
-	Parent(nullptr),
 	Peer(nullptr),
 	Map(nullptr),
 	Log(nullptr),
 	TimeSteps(0),
 	Lifetime(-1),
+	Activity(ACTIVE),
+	MapIndex(-1),
+	ActiveIndex(-1),
+	ShapelessIndex(-1),
 	SendUpdate(false),
 	Server(false),
 	Event(false),
+	PendingDelete(false),
 	Identifier(""),
 	Name("") {
 
@@ -62,6 +69,10 @@ _Object::~_Object() {
 // Update
 void _Object::Update(double FrameTime) {
 
+	// Skip static and sleeping objects
+	if(Activity != ACTIVE)
+		return;
+
 	// Update components
 	for(auto &Component : Components) {
 		if(Component.second->UpdateAutomatically)
@@ -76,13 +87,37 @@ void _Object::Update(double FrameTime) {
 	}
 
 	// Delete object
-	if(Lifetime == 0.0f)
-		Deleted = true;
+	if(Lifetime == 0.0f) {
+		if(Map)
+			Map->DestroyObject(this);
+		else
+			Deleted = true;
+	}
+}
+
+// Wake a sleeping object
+void _Object::Wake() {
+	if(Activity != SLEEPING)
+		return;
+
+	SetActivity(ACTIVE);
+	if(Physics)
+		Physics->RestTicks = 0;
+}
+
+// Change activity and keep the map's active list in sync
+void _Object::SetActivity(int Activity) {
+	if(this->Activity == Activity)
+		return;
+
+	this->Activity = Activity;
+	if(Map)
+		Map->UpdateActiveObject(this);
 }
 
 // Serialize components
 void _Object::NetworkSerialize(ae::_Buffer &Buffer) {
-	Buffer.WriteString(Identifier.c_str());
+	_StringTable::WriteString(Map ? Map->StringTable : nullptr, Buffer, Identifier);
 	Buffer.Write<ae::NetworkIDType>(NetworkID);
 
 	for(auto &Component : Components)
@@ -122,7 +157,7 @@ void _Object::NetworkUnserializeUpdate(ae::_Buffer &Buffer, uint16_t TimeSteps)
 }
 
 // Check collision with a min max AABB
-bool _Object::CheckAABB(const glm::vec4 &AABB) {
+bool _Object::CheckAABB(const glm::vec4 &AABB) const {
 	if(!Shape)
 		return true;
 
@@ -162,8 +197,72 @@ bool _Object::CheckAABB(const glm::vec4 &AABB) {
 	return true;
 }
 
+// Check collision with a box centered at position, push is applied to the box
+bool _Object::CheckBox(const glm::vec2 &Position, const glm::vec2 &HalfWidth, glm::vec2 &Push, bool &AxisAlignedPush) const {
+
+	// Get vector to box center
+	glm::vec2 Point = Position - glm::vec2(Physics->Position);
+
+	// Shape is AABB
+	if(Shape->IsAABB()) {
+
+		// Get overlap on each axis
+		glm::vec2 Overlap = HalfWidth + glm::vec2(Shape->HalfWidth) - glm::abs(Point);
+		if(Overlap.x <= 0.0f || Overlap.y <= 0.0f)
+			return false;
+
+		// Push out along the axis of least penetration
+		Push = glm::vec2(0.0f);
+		if(Overlap.x < Overlap.y)
+			Push.x = Point.x < 0.0f ? -Overlap.x : Overlap.x;
+		else
+			Push.y = Point.y < 0.0f ? -Overlap.y : Overlap.y;
+
+		AxisAlignedPush = true;
+
+		return true;
+	}
+	else {
+
+		// Get closest point on box to circle center
+		glm::vec2 Center = -Point;
+		glm::vec2 ClosestPoint = glm::clamp(Center, -HalfWidth, HalfWidth);
+		int ClampCount = (ClosestPoint.x != Center.x) + (ClosestPoint.y != Center.y);
+
+		float Radius = Shape->HalfWidth[0];
+		float DistanceSquared = glm::distance2(Center, ClosestPoint);
+		if(DistanceSquared >= Radius * Radius)
+			return false;
+
+		// Circle center is inside the box
+		if(ClampCount == 0) {
+			glm::vec2 Overlap = HalfWidth - glm::abs(Center);
+			Push = glm::vec2(0.0f);
+			if(Overlap.x < Overlap.y)
+				Push.x = Center.x < 0.0f ? Overlap.x + Radius : -(Overlap.x + Radius);
+			else
+				Push.y = Center.y < 0.0f ? Overlap.y + Radius : -(Overlap.y + Radius);
+
+			AxisAlignedPush = true;
+
+			return true;
+		}
+
+		// Push box away from circle
+		float Distance = std::sqrt(DistanceSquared);
+		Push = (ClosestPoint - Center) / Distance * (Radius - Distance);
+
+		if(ClampCount == 1)
+			AxisAlignedPush = true;
+
+		return true;
+	}
+
+	return false;
+}
+
 // Check collision with a circle
-bool _Object::CheckCircle(const glm::vec2 &Position, float Radius, glm::vec2 &Push, bool &AxisAlignedPush) {
+bool _Object::CheckCircle(const glm::vec2 &Position, float Radius, glm::vec2 &Push, bool &AxisAlignedPush) const {
 
 	// Get vector to circle center
 	glm::vec2 Point = Position - glm::vec2(Physics->Position);
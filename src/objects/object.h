@@ -18,6 +18,7 @@
 #pragma once
 
 // Libraries
+#include <handle.h>
 #include <ae/baseobject.h>
 #include <glm/vec4.hpp>
 #include <glm/vec2.hpp>
@@ -44,11 +45,20 @@ class _Object : public ae::_BaseObject {
 
 	public:
 
+		enum ActivityType {
+			ACTIVE,
+			SLEEPING,
+			STATIC,
+		};
+
 		_Object();
 		~_Object();
 
 		// Updates
 		void Update(double FrameTime);
+		void Wake();
+		void SetActivity(int Activity);
+		bool IsActive() const { return Activity == ACTIVE; }
 
 		// Network
 		void NetworkSerialize(ae::_Buffer &Buffer);
@@ -57,10 +67,11 @@ class _Object : public ae::_BaseObject {
 		void NetworkUnserializeUpdate(ae::_Buffer &Buffer, uint16_t TimeSteps);
 
 		// Collision
-		bool CheckCircle(const glm::vec2 &Position, float Radius, glm::vec2 &Push, bool &AxisAlignedPush);
-		bool CheckAABB(const glm::vec4 &AABB);
+		bool CheckCircle(const glm::vec2 &Position, float Radius, glm::vec2 &Push, bool &AxisAlignedPush) const;
+		bool CheckBox(const glm::vec2 &Position, const glm::vec2 &HalfWidth, glm::vec2 &Push, bool &AxisAlignedPush) const;
+		bool CheckAABB(const glm::vec4 &AABB) const;
 
-		inline bool HasComponent(const std::string &Name) { return Components.find(Name) != Components.end(); }
+		inline bool HasComponent(const std::string &Name) const { return Components.find(Name) != Components.end(); }
 
 		// Components
 		_Physics *Physics;
@@ -70,8 +81,11 @@ class _Object : public ae::_BaseObject {
 
 		std::unordered_map<std::string, _Component *> Components;
 
+		// Handles
+		_Handle Handle;
+		_Handle Parent;
+
 		// Pointers
-		_Object *Parent;
 		ae::_Peer *Peer;
 		_Map *Map;
 		ae::_LogFile *Log;
@@ -79,9 +93,14 @@ class _Object : public ae::_BaseObject {
 		// Attributes
 		uint16_t TimeSteps;
 		float Lifetime;
+		int Activity;
+		int MapIndex;
+		int ActiveIndex;
+		int ShapelessIndex;
 		bool SendUpdate;
 		bool Server;
 		bool Event;
+		bool PendingDelete;
 		std::string Identifier;
 		std::string Name;
 
@@ -24,12 +24,14 @@
 #include <constants.h>
 #include <map.h>
 #include <grid.h>
-#include <scripting.h>
+#include <arena.h>
 #include <stats.h>
 #include <ae/buffer.h>
+#include <algorithm>
 #include <cmath>
 #include <map>
 #include <iostream>
+#include <glm/geometric.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 // Constructor
@@ -41,6 +43,7 @@ _Physics::_Physics(_Object *Parent, const _PhysicsStat *Stats) :
 	Velocity(0),
 	Rotation(0.0f),
 	InterpolatedRotation(0.0f),
+	RestTicks(0),
 	RenderDelay(true),
 	CollisionResponse(Stats->CollisionResponse) {
 
@@ -59,7 +62,7 @@ void _Physics::NetworkSerialize(ae::_Buffer &Buffer) {
 
 // Unserialize
 void _Physics::NetworkUnserialize(ae::_Buffer &Buffer) {
-	NetworkPosition = Position = Buffer.Read<glm::vec3>();
+	NetworkPosition = LastPosition = Position = Buffer.Read<glm::vec3>();
 	InterpolatedRotation = Rotation = Buffer.Read<float>();
 }
 
@@ -92,6 +95,160 @@ void _Physics::ForcePosition(const glm::vec2 &Position) {
 	NetworkPosition = LastPosition = this->Position = glm::vec3(Position, 0.0f);
 }
 
+// Move a position by delta, sweeping fast objects so they can't tunnel through thin walls
+void _Physics::Move(const _Grid *Grid, glm::vec2 &Position, const glm::vec2 &Delta, _Contact *Contact) const {
+
+	// Slow objects rely on the push out step
+	float Radius = Parent->Shape ? std::min(Parent->Shape->HalfWidth[0], Parent->Shape->IsAABB() ? Parent->Shape->HalfWidth[1] : Parent->Shape->HalfWidth[0]) : 0.0f;
+	float Threshold = Radius * PHYSICS_CCD_THRESHOLD;
+	if(glm::dot(Delta, Delta) <= Threshold * Threshold) {
+		Position += Delta;
+		return;
+	}
+
+	// Slide along surfaces that are hit
+	glm::vec2 Remaining = Delta;
+	for(int i = 0; i < PHYSICS_CCD_ITERATIONS; i++) {
+		float HitTime;
+		glm::vec2 Normal;
+		AddReadBounds(Grid, Position, Contact);
+		AddReadBounds(Grid, Position + Remaining, Contact);
+		if(!Grid->SweepObject(Parent, Position, Remaining, HitTime, Normal)) {
+			Position += Remaining;
+			return;
+		}
+
+		// Stop just short of the surface
+		float Length = glm::length(Remaining);
+		float SafeTime = std::max(HitTime - PHYSICS_CCD_SKIN / Length, 0.0f);
+		Position += Remaining * SafeTime;
+
+		// Remove the blocked component
+		Remaining *= 1.0f - SafeTime;
+		Remaining -= Normal * glm::dot(Remaining, Normal);
+		if(glm::dot(Remaining, Remaining) == 0.0f)
+			return;
+	}
+}
+
+// Integrate velocity and gather contacts, only writes to this component so it can run on any thread
+void _Physics::Detect(const _Grid *Grid) {
+	Contact.Touched.clear();
+	Contact.Bounds = glm::ivec4(Grid->Size.x, Grid->Size.y, -1, -1);
+	Contact.Position = glm::vec2(Position);
+	Contact.Moved = !(Velocity.x == 0.0f && Velocity.y == 0.0f);
+	if(!Contact.Moved)
+		return;
+
+	Step(Grid, Contact.Position, &Contact);
+}
+
+// Run one step from a given position without touching the grid or this component's state
+void _Physics::Predict(const _Grid *Grid, glm::vec2 &Position) const {
+	if(Velocity.x == 0.0f && Velocity.y == 0.0f)
+		return;
+
+	Step(Grid, Position, nullptr);
+}
+
+// Move to a position, only moving between grid tiles when it changes
+void _Physics::SetPosition(const glm::vec2 &NewPosition) {
+	LastPosition = Position;
+	if(NewPosition.x == Position.x && NewPosition.y == Position.y)
+		return;
+
+	Parent->Map->Grid->RemoveObject(Parent);
+	Position.x = NewPosition.x;
+	Position.y = NewPosition.y;
+	Parent->Map->Grid->AddObject(Parent);
+}
+
+// Integrate velocity, clamp to the map and push out of other objects
+void _Physics::Step(const _Grid *Grid, glm::vec2 &Position, _Contact *Contact) const {
+	Move(Grid, Position, glm::vec2(Velocity), Contact);
+
+	// Check map boundaries
+	Grid->ClampObject(Parent, Position);
+
+	// Iterate twice
+	for(int i = 0; i < 2; i++) {
+
+		// Get a list of entities that the object is colliding with
+		_ArenaVector<_Push> Pushes(FrameArena);
+		bool AxisAlignedPush = false;
+		AddReadBounds(Grid, Position, Contact);
+		Grid->CheckCollisions(Parent, Position, Pushes, AxisAlignedPush);
+
+		// Apply pushes
+		for(auto &Push : Pushes) {
+
+			// If any axis aligned pushes are detected, ignore diagonal pushes
+			if(Push.Object->Physics->CollisionResponse && !(AxisAlignedPush && Push.IsDiagonal()))
+				Position += Push.Direction;
+
+			if(Contact)
+				Contact->Touched.push_back(Push.Object);
+		}
+	}
+}
+
+// Grow the range of tiles read during detection to cover the object at a position
+void _Physics::AddReadBounds(const _Grid *Grid, const glm::vec2 &Position, _Contact *Contact) const {
+	if(!Contact)
+		return;
+
+	glm::ivec4 Bounds;
+	Grid->GetTileBounds(Parent, Position, Bounds);
+	Contact->Bounds[0] = std::min(Contact->Bounds[0], Bounds[0]);
+	Contact->Bounds[1] = std::min(Contact->Bounds[1], Bounds[1]);
+	Contact->Bounds[2] = std::max(Contact->Bounds[2], Bounds[2]);
+	Contact->Bounds[3] = std::max(Contact->Bounds[3], Bounds[3]);
+}
+
+// Apply the result of the detection phase, must be called serially
+void _Physics::Resolve() {
+	LastPosition = Position;
+
+	if(Contact.Moved) {
+		Parent->Map->Grid->RemoveObject(Parent);
+		Position.x = Contact.Position.x;
+		Position.y = Contact.Position.y;
+		Parent->Map->Grid->AddObject(Parent);
+
+		for(auto &Object : Contact.Touched) {
+
+			// Wake objects that were bumped into
+			Object->Wake();
+
+			// Update zone occupants on server
+			if(Parent->Peer && Object->HasComponent("zone"))
+				Parent->Map->EnterZone((_Zone *)(Object->Components["zone"]), Parent);
+		}
+	}
+
+	// Determine if the object has moved
+	if(LastPosition != Position) {
+		Parent->SendUpdate = true;
+		RestTicks = 0;
+
+		//PositionChanged = true;
+		if(Parent->Animation)
+			Parent->Animation->Play(0);
+	}
+	else {
+		if(Parent->Animation)
+			Parent->Animation->Stop();
+		//PositionChanged = false;
+
+		// Put resting server objects to sleep
+		if(Parent->Server && !Parent->Peer && Parent->Lifetime < 0.0f) {
+			RestTicks++;
+			if(RestTicks >= OBJECT_SLEEP_TICKS && Parent->Activity == _Object::ACTIVE)
+				Parent->SetActivity(_Object::SLEEPING);
+		}
+	}
+}
+
 // Update
 void _Physics::Update(double FrameTime) {
 	LastPosition = Position;
@@ -100,16 +257,19 @@ void _Physics::Update(double FrameTime) {
 	if(RenderDelay && History.Size() >= 3) {
 
 		// Get rendertime
-		uint16_t RenderTime = Parent->TimeSteps - 10;
-
-		// Find the timestep to the right of the rendertime
-		int End = 0;
-		for(int i = 0; i < History.Size(); i++) {
-			End = i-1;
-			if(ae::_Network::MoreRecentAck(History.Back(i).Time, RenderTime, uint16_t(-1))) {
-				break;
-			}
+		uint16_t RenderTime = Parent->Map->GetRenderTime(Parent->TimeSteps);
+
+		// Binary search for the newest snapshot older than the rendertime, the one before it is to the right
+		int Low = 0;
+		int High = History.Size();
+		while(Low < High) {
+			int Middle = (Low + High) / 2;
+			if(ae::_Network::MoreRecentAck(History.Back(Middle).Time, RenderTime, uint16_t(-1)))
+				High = Middle;
+			else
+				Low = Middle + 1;
 		}
+		int End = std::min(Low - 1, History.Size() - 2);
 
 		// Check for no positions found within buffer time, then extrapolate
 		int Start;
@@ -124,12 +284,31 @@ void _Physics::Update(double FrameTime) {
 			InterpolationIndex = Start;
 		}
 
-		// Get interpolation amount
-		float Percentage = float(RenderTime - History.Back(InterpolationIndex).Time) / (History.Back(End).Time - History.Back(Start).Time);
+		// Get interpolation amount, snapshots that arrived on the same tick don't move
+		float Percentage = 0.0f;
+		int16_t Span = int16_t(History.Back(End).Time - History.Back(Start).Time);
+		if(Span)
+			Percentage = float(int16_t(RenderTime - History.Back(InterpolationIndex).Time)) / Span;
 		glm::vec3 DeltaPosition = History.Back(End).Position - History.Back(Start).Position;
+		glm::vec3 NewPosition = History.Back(InterpolationIndex).Position + DeltaPosition * Percentage;
+
+		// Only move between grid tiles when the tile bounds change
+		_Grid *Grid = Parent->Map->Grid;
+		bool Rebucket = false;
+		if(Parent->Shape) {
+			glm::ivec4 OldBounds;
+			glm::ivec4 NewBounds;
+			Grid->GetTileBounds(Parent, OldBounds);
+			Grid->GetTileBounds(Parent, glm::vec2(NewPosition), NewBounds);
+			Rebucket = OldBounds != NewBounds;
+		}
+
 		LastPosition = Position;
-		Parent->Map->Grid->RemoveObject(Parent);
-		Position = History.Back(InterpolationIndex).Position + DeltaPosition * Percentage;
+		if(Rebucket)
+			Grid->RemoveObject(Parent);
+		Position = NewPosition;
+		if(Rebucket)
+			Grid->AddObject(Parent);
 
 		if(Parent->Animation) {
 			if(Position != LastPosition)
@@ -137,7 +316,6 @@ void _Physics::Update(double FrameTime) {
 			else
 				Parent->Animation->Stop();
 		}
-		Parent->Map->Grid->AddObject(Parent);
 
 		// Update rotation
 		float DeltaRotation = Rotation - InterpolatedRotation;
@@ -154,76 +332,7 @@ void _Physics::Update(double FrameTime) {
 	}
 
 	if(!RenderDelay) {
-
-		if(!(Velocity.x == 0.0f && Velocity.y == 0.0f)) {
-			Parent->Map->Grid->RemoveObject(Parent);
-			Parent->Physics->Position += Velocity;
-
-			// Check map boundaries
-			Parent->Map->Grid->ClampObject(Parent);
-
-			// Iterate twice
-			for(int i = 0; i < 2; i++) {
-
-				// Get a list of entities that the object is colliding with
-				std::list<_Push> Pushes;
-				bool AxisAlignedPush = false;
-				Parent->Map->Grid->CheckCollisions(Parent, Pushes, AxisAlignedPush);
-
-				// Apply pushes
-				for(auto &Push : Pushes) {
-
-					// If any axis aligned pushes are detected, ignore diagonal pushes
-					if(Push.Object->Physics->CollisionResponse && !(AxisAlignedPush && Push.IsDiagonal()))
-						Parent->Physics->Position += glm::vec3(Push.Direction, 0);
-
-					// Reset last collision id
-					Push.Object->Shape->LastCollisionID = -1;
-
-					// Update zone callbacks on server
-					if(Parent->Peer && Push.Object->HasComponent("zone")) {
-						if(Touching.find(Push.Object) == Touching.end()) {
-							_Zone *Zone = (_Zone *)(Push.Object->Components["zone"]);
-
-							//std::cout << "Touching " << Push.Object << std::endl;
-							if(Zone->OnEnter != "") {
-								Parent->Map->Scripting->ExecuteLua(Zone->OnEnter, Parent);
-							}
-						}
-
-						Touching[Push.Object] = 2;
-					}
-				}
-			}
-
-			Parent->Map->Grid->AddObject(Parent);
-		}
-
-		// Determine if the object has moved
-		if(LastPosition != Parent->Physics->Position) {
-
-			// Update zone touching state on server
-			if(Parent->Peer) {
-				for(auto Iterator = Touching.begin(); Iterator != Touching.end(); ) {
-					Iterator->second--;
-
-					if(Iterator->second <= 0) {
-						//std::cout << "Out of " << Iterator->first << std::endl;
-						Iterator = Touching.erase(Iterator);
-					}
-					else
-						++Iterator;
-				}
-			}
-
-			//PositionChanged = true;
-			if(Parent->Animation)
-				Parent->Animation->Play(0);
-		}
-		else {
-			if(Parent->Animation)
-				Parent->Animation->Stop();
-			//PositionChanged = false;
-		}
+		Detect(Parent->Map->Grid);
+		Resolve();
 	}
 }
@@ -22,11 +22,13 @@
 #include <ae/circular_buffer.h>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include <cstdint>
-#include <unordered_map>
+#include <vector>
 
 // Forward Declarations
 struct _PhysicsStat;
+class _Grid;
 
 // Classes
 class _Physics : public _Component {
@@ -41,11 +43,23 @@ class _Physics : public _Component {
 			uint16_t Time;
 		};
 
+		// Result of the detection phase
+		struct _Contact {
+			std::vector<_Object *> Touched;
+			glm::ivec4 Bounds;
+			glm::vec2 Position;
+			bool Moved;
+		};
+
 		_Physics(_Object *Parent, const _PhysicsStat *Stats);
 		~_Physics();
 
 		// Updates
 		void Update(double FrameTime) override;
+		void Detect(const _Grid *Grid);
+		void Resolve();
+		void Predict(const _Grid *Grid, glm::vec2 &Position) const;
+		void SetPosition(const glm::vec2 &NewPosition);
 		void ForcePosition(const glm::vec2 &Position);
 		void FacePosition(const glm::vec2 &Cursor);
 
@@ -56,15 +70,21 @@ class _Physics : public _Component {
 		void NetworkUnserializeUpdate(ae::_Buffer &Buffer, uint16_t TimeSteps) override;
 
 		// Attributes
-		std::unordered_map<_Object *, int> Touching;
-
 		ae::_CircularBuffer<_History> History;
+		_Contact Contact;
 		glm::vec3 Position;
 		glm::vec3 LastPosition;
 		glm::vec3 NetworkPosition;
 		glm::vec3 Velocity;
 		float Rotation;
 		float InterpolatedRotation;
+		int RestTicks;
 		bool RenderDelay : 1;
 		bool CollisionResponse : 1;
+
+	private:
+
+		void Move(const _Grid *Grid, glm::vec2 &Position, const glm::vec2 &Delta, _Contact *Contact) const;
+		void Step(const _Grid *Grid, glm::vec2 &Position, _Contact *Contact) const;
+		void AddReadBounds(const _Grid *Grid, const glm::vec2 &Position, _Contact *Contact) const;
 };
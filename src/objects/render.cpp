@@ -22,6 +22,9 @@
 #include <objects/shape.h>
 #include <objects/shot.h>
 #include <stats.h>
+#include <map.h>
+#include <stringtable.h>
+#include <renderbatch.h>
 #include <ae/graphics.h>
 #include <ae/buffer.h>
 #include <ae/program.h>
@@ -51,31 +54,28 @@ _Render::~_Render() {
 
 // Serialize
 void _Render::NetworkSerialize(ae::_Buffer &Buffer) {
-	if(!Texture)
-		Buffer.WriteString("");
-	else
-		Buffer.WriteString(Texture->Name.c_str());
+	const _StringTable *StringTable = Parent->Map ? Parent->Map->StringTable : nullptr;
+	_StringTable::WriteString(StringTable, Buffer, Texture ? Texture->Name : "");
 }
 
 // Unserialize
 void _Render::NetworkUnserialize(ae::_Buffer &Buffer) {
-	std::string TextureIdentifier = Buffer.ReadString();
+	const _StringTable *StringTable = Parent->Map ? Parent->Map->StringTable : nullptr;
+	std::string TextureIdentifier = _StringTable::ReadString(StringTable, Buffer);
 	Texture = ae::Assets.Textures[TextureIdentifier];
 }
 
-// Draw the object
+// Draw the object on its own
 void _Render::Draw3D(double BlendFactor) {
-	ae::Graphics.SetProgram(Program);
-
-	/*
-	if(Parent->Physics->Interpolate) {
-		for(int i = 0; i < Parent->Physics->History.Size(); i++) {
-			const glm::vec2 &P = Parent->Physics->History.Back(i).Position;
-			ae::Graphics.DrawTexture(P.X, P.Y, Parent->PositionZ, Icon, COLOR_BLUE, Parent->Physics->InterpolatedRotation, Parent->Scale, Parent->Scale);
-		}
-	}
-	*/
+	_RenderBatch Batch;
+	AddDrawItems(Batch, BlendFactor);
+	Batch.Build();
+	Batch.Submit();
+	DrawDebug();
+}
 
+// Add draw items for the object to a batch
+void _Render::AddDrawItems(_RenderBatch &Batch, double BlendFactor) const {
 	glm::vec3 DrawPosition;
 	float DrawRotation = 0.0f;
 
@@ -89,78 +89,59 @@ void _Render::Draw3D(double BlendFactor) {
 			DrawRotation = Parent->Physics->Rotation;
 	}
 
-	ae::Graphics.SetColor(Color);
+	_DrawItem Item;
+	Item.Program = Program;
+	Item.Texture = Texture;
+	Item.Mesh = nullptr;
+	Item.Color = Color;
+	Item.TextureCoords = glm::vec4(0.0f);
+	Item.Position = glm::vec3(DrawPosition.x, DrawPosition.y, Stats->Z);
+	Item.Size = glm::vec3(Stats->Scale);
+	Item.Rotation = DrawRotation;
 	if(Parent->Animation) {
-
-		// Draw server position
-		if(Debug & DEBUG_NETWORK) {
-			ae::Graphics.SetColor(glm::vec4(1.0f, 0, 0, 1.0f));
-			ae::Graphics.DrawAnimationFrame(
-				glm::vec3(Parent->Physics->NetworkPosition.x, Parent->Physics->NetworkPosition.y, Stats->Z),
-				Parent->Animation->Templates[Parent->Animation->Reel]->Texture,
-				Parent->Animation->TextureCoords,
-				DrawRotation,
-				glm::vec2(Stats->Scale)
-			);
-			ae::Graphics.SetColor(Color);
-		}
-
-		// Draw animation frame
-		ae::Graphics.DrawAnimationFrame(
-			glm::vec3(DrawPosition.x, DrawPosition.y, Stats->Z),
-			Parent->Animation->Templates[Parent->Animation->Reel]->Texture,
-			glm::vec4(Parent->Animation->TextureCoords),
-			DrawRotation,
-			glm::vec2(Stats->Scale)
-		);
+		Item.Type = _DrawItem::ANIMATION;
+		Item.Texture = Parent->Animation->Templates[Parent->Animation->Reel]->Texture;
+		Item.TextureCoords = glm::vec4(Parent->Animation->TextureCoords);
 	}
 	else if(Mesh) {
-		glUniformMatrix4fv(Program->ModelTransformID, 1, GL_FALSE, glm::value_ptr(glm::translate(glm::mat4(1.0f), glm::vec3(DrawPosition.x, DrawPosition.y, Stats->Z))));
-		ae::Graphics.SetTextureID(Texture->ID);
-		ae::Graphics.SetVertexBufferID(Mesh->VertexBufferID);
-		ae::Graphics.EnableAttribs(3);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ae::_PackedVertex), ae::_PackedVertex::GetPositionOffset());
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ae::_PackedVertex), ae::_PackedVertex::GetUVOffset());
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(ae::_PackedVertex), ae::_PackedVertex::GetNormalOffset());
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Mesh->ElementBufferID);
-		glDrawElements(GL_TRIANGLES, Mesh->IndexCount, GL_UNSIGNED_INT, 0);
+		Item.Type = _DrawItem::MESH;
+		Item.Mesh = Mesh;
 	}
 	// Draw cube
 	else if(Stats->Layer == 0) {
-		ae::Graphics.SetColor(glm::vec4(1.0f));
-		ae::Graphics.DrawCube(DrawPosition - Parent->Shape->HalfWidth, Parent->Shape->HalfWidth * 2.0f, Texture);
+		Item.Type = _DrawItem::CUBE;
+		Item.Color = glm::vec4(1.0f);
+		Item.Position = DrawPosition - Parent->Shape->HalfWidth;
+		Item.Size = Parent->Shape->HalfWidth * 2.0f;
 	}
 	else if(Texture) {
-
-		// Draw server position
-		if(Debug & DEBUG_NETWORK) {
-			ae::Graphics.SetColor(glm::vec4(1.0f, 0, 0, 1.0f));
-			ae::Graphics.DrawSprite(
-				glm::vec3(Parent->Physics->NetworkPosition.x, Parent->Physics->NetworkPosition.y, Stats->Z),
-				Texture,
-				DrawRotation,
-				glm::vec2(Stats->Scale)
-			);
-			ae::Graphics.SetColor(Color);
-		}
-
-		ae::Graphics.DrawSprite(
-			glm::vec3(DrawPosition.x, DrawPosition.y, Stats->Z),
-			Texture,
-			DrawRotation,
-			glm::vec2(Stats->Scale)
-		);
+		Item.Type = _DrawItem::SPRITE;
 	}
 	else {
-		ae::Graphics.DrawRectangle3D(glm::vec2(DrawPosition - Parent->Shape->HalfWidth), glm::vec2(DrawPosition + Parent->Shape->HalfWidth), true);
+		Item.Type = _DrawItem::RECTANGLE;
+		Item.Position = DrawPosition - Parent->Shape->HalfWidth;
+		Item.Size = Parent->Shape->HalfWidth * 2.0f;
 	}
 
-	// Draw object id
-	if(Debug & DEBUG_ID) {
-		ae::Graphics.SetDepthTest(false);
-		std::ostringstream Buffer;
-		Buffer << Parent->NetworkID;
-		ae::Assets.Fonts["menu_buttons"]->DrawText(Buffer.str(), glm::vec2(Parent->Physics->Position), ae::CENTER_BASELINE, glm::vec4(1.0f), 1.0f / 64.0f);
-		ae::Graphics.SetDepthTest(true);
+	// Draw server position
+	if((Debug & DEBUG_NETWORK) && (Item.Type == _DrawItem::ANIMATION || Item.Type == _DrawItem::SPRITE)) {
+		_DrawItem NetworkItem = Item;
+		NetworkItem.Color = glm::vec4(1.0f, 0, 0, 1.0f);
+		NetworkItem.Position = glm::vec3(Parent->Physics->NetworkPosition.x, Parent->Physics->NetworkPosition.y, Stats->Z);
+		Batch.Add(NetworkItem);
 	}
+
+	Batch.Add(Item);
+}
+
+// Draw object id
+void _Render::DrawDebug() const {
+	if(!(Debug & DEBUG_ID))
+		return;
+
+	ae::Graphics.SetDepthTest(false);
+	std::ostringstream Buffer;
+	Buffer << Parent->NetworkID;
+	ae::Assets.Fonts["menu_buttons"]->DrawText(Buffer.str(), glm::vec2(Parent->Physics->Position), ae::CENTER_BASELINE, glm::vec4(1.0f), 1.0f / 64.0f);
+	ae::Graphics.SetDepthTest(true);
 }
@@ -23,6 +23,7 @@
 
 // Forward Declarations
 struct _RenderStat;
+class _RenderBatch;
 
 namespace ae {
 	class _Program;
@@ -50,6 +51,8 @@ class _Render : public _Component {
 		void NetworkUnserialize(ae::_Buffer &Buffer) override;
 
 		void Draw3D(double BlendFactor);
+		void AddDrawItems(_RenderBatch &Batch, double BlendFactor) const;
+		void DrawDebug() const;
 
 		const _RenderStat *Stats;
 		const ae::_Program *Program;
@@ -22,8 +22,7 @@
 // Constructor
 _CollisionShape::_CollisionShape(_Object *Parent, const _CollisionShapeStat *Stat) :
 	_Component(Parent),
-	HalfWidth(Stat->HalfWidth),
-	LastCollisionID(-1) {
+	HalfWidth(Stat->HalfWidth) {
 }
 
 // Destructor
@@ -42,6 +42,5 @@ class _CollisionShape : public _Component {
 
 		// Attributes
 		glm::vec3 HalfWidth;
-		uint32_t LastCollisionID;
 
 };
@@ -56,16 +56,24 @@ void _Shot::Update(double FrameTime) {
 	// Notify clients
 	if(Impact.Object) {
 
+		// Wake object that was hit
+		Impact.Object->Wake();
+
 		// Check for health
 		if(Impact.Object->HasComponent("health")) {
 			_Health *Health = (_Health *)(Impact.Object->Components["health"]);
 
 			// Update health
+			const _Object *Owner = Parent->Map->GetObject(Parent->Parent);
+			bool WasAlive = Health->Health > 0;
 			Health->Health -= 10;
+			Parent->Map->QueueScriptEvent(Parent->Map->OnDamageReference, Impact.Object, Owner, 10);
 			if(Health->Health <= 0) {
 				Health->Health = 0;
+				if(WasAlive)
+					Parent->Map->QueueScriptEvent(Parent->Map->OnDeathReference, Impact.Object, Owner, 0);
 				if(Impact.Object->Identifier != "player")
-					Impact.Object->Deleted = true;
+					Parent->Map->DestroyObject(Impact.Object);
 			}
 
 			ae::_Buffer Buffer;
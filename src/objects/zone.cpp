@@ -16,14 +16,45 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *******************************************************************************/
 #include <objects/zone.h>
+#include <objects/object.h>
+#include <objects/physics.h>
+#include <objects/shape.h>
 #include <stats.h>
 #include <ae/buffer.h>
+#include <lua.hpp>
+#include <algorithm>
 
 // Constructor
 _Zone::_Zone(_Object *Parent, const _ZoneStat *Stat) :
-	_Component(Parent) {
+	_Component(Parent),
+	OnEnterReference(LUA_NOREF),
+	OnLeaveReference(LUA_NOREF),
+	ZoneIndex(-1) {
 }
 
 // Destructor
 _Zone::~_Zone() {
 }
+
+// Check if an object overlaps the zone
+bool _Zone::Contains(const _Object *Object) const {
+	if(!Object->Physics || !Object->Shape)
+		return false;
+
+	glm::vec2 Push;
+	bool AxisAlignedPush;
+	if(Object->Shape->IsAABB())
+		return Parent->CheckBox(glm::vec2(Object->Physics->Position), glm::vec2(Object->Shape->HalfWidth), Push, AxisAlignedPush);
+
+	return Parent->CheckCircle(glm::vec2(Object->Physics->Position), Object->Shape->HalfWidth[0], Push, AxisAlignedPush);
+}
+
+// Add an object to the occupant list, returns true if it wasn't already inside
+bool _Zone::AddOccupant(const _Object *Object) {
+	if(std::find(Occupants.begin(), Occupants.end(), Object->Handle) != Occupants.end())
+		return false;
+
+	Occupants.push_back(Object->Handle);
+
+	return true;
+}
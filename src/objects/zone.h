@@ -19,7 +19,9 @@
 
 // Libraries
 #include <objects/component.h>
+#include <handle.h>
 #include <string>
+#include <vector>
 
 // Forward Declarations
 struct _ZoneStat;
@@ -32,8 +34,19 @@ class _Zone : public _Component {
 		_Zone(_Object *Parent, const _ZoneStat *Stats);
 		~_Zone();
 
+		bool Contains(const _Object *Object) const;
+		bool AddOccupant(const _Object *Object);
+
 		// Scripting callbacks
 		std::string OnEnter;
 		std::string OnLeave;
+		int OnEnterReference;
+		int OnLeaveReference;
+
+		// Objects inside the zone, stale handles are dropped when the map updates zones
+		std::vector<_Handle> Occupants;
+
+		// Position in the map's zone list
+		int ZoneIndex;
 
 };
@@ -31,6 +31,7 @@ namespace Packet {
 		CLIENT_USE,
 		CLIENT_ATTACK,
 		UPDATE_HEALTH,
+		STRING_TABLE,
 	};
 
 }
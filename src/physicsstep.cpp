@@ -0,0 +1,128 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <physicsstep.h>
+#include <objects/physics.h>
+#include <objects/object.h>
+#include <grid.h>
+#include <workerpool.h>
+#include <constants.h>
+#include <algorithm>
+#include <chrono>
+
+// Constructor
+_PhysicsStep::_PhysicsStep() :
+	WorkerPool(nullptr),
+	DetectTime(0.0),
+	ResolveTime(0.0),
+	RedetectCount(0),
+	Stamp(0) {
+}
+
+// Integrate and gather contacts for all bodies against the current grid
+void _PhysicsStep::Detect(const _Grid *Grid) {
+	auto StartTime = std::chrono::steady_clock::now();
+
+	// Small steps aren't worth the thread overhead
+	size_t Threads = 1;
+	if(WorkerPool)
+		Threads = std::min((size_t)WorkerPool->GetThreadCount(), Bodies.size() / PHYSICS_PARALLEL_MIN_BODIES);
+
+	if(Threads <= 1) {
+		DetectRange(Grid, 0, Bodies.size());
+	}
+	else {
+
+		// Split bodies into contiguous ranges
+		size_t RangeSize = (Bodies.size() + Threads - 1) / Threads;
+		WorkerPool->Run(Threads, [this, Grid, RangeSize](size_t Range) {
+			DetectRange(Grid, Range * RangeSize, (Range + 1) * RangeSize);
+		});
+	}
+
+	DetectTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+// Apply contacts in body order so the result doesn't depend on thread count
+void _PhysicsStep::Resolve(const _Grid *Grid) {
+	auto StartTime = std::chrono::steady_clock::now();
+
+	// Start a new generation of changed tiles
+	size_t TileCount = (size_t)Grid->Size.x * Grid->Size.y;
+	Stamp++;
+	if(TileStamps.size() != TileCount || !Stamp) {
+		TileStamps.assign(TileCount, 0);
+		Stamp = 1;
+	}
+
+	RedetectCount = 0;
+	for(auto &Body : Bodies) {
+		if(!Body->Contact.Moved) {
+			Body->Resolve();
+			continue;
+		}
+
+		// Detection saw stale tiles, so run it again against the bodies already resolved
+		if(IsChanged(Grid, Body->Contact.Bounds)) {
+			Body->Detect(Grid);
+			RedetectCount++;
+		}
+
+		// Bodies without a shape aren't in the grid
+		if(!Body->Parent->Shape) {
+			Body->Resolve();
+			continue;
+		}
+
+		// Later bodies reading the old or new tiles need to see this move
+		glm::ivec4 Bounds;
+		Grid->GetTileBounds(Body->Parent, Bounds);
+		MarkChanged(Grid, Bounds);
+		Body->Resolve();
+		Grid->GetTileBounds(Body->Parent, Bounds);
+		MarkChanged(Grid, Bounds);
+	}
+
+	ResolveTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+// Detect a range of bodies
+void _PhysicsStep::DetectRange(const _Grid *Grid, size_t Start, size_t End) {
+	End = std::min(End, Bodies.size());
+	for(size_t i = Start; i < End; i++)
+		Bodies[i]->Detect(Grid);
+}
+
+// Check if any tile in a range was written during this resolve
+bool _PhysicsStep::IsChanged(const _Grid *Grid, const glm::ivec4 &Bounds) const {
+	for(int j = Bounds[1]; j <= Bounds[3]; j++) {
+		for(int i = Bounds[0]; i <= Bounds[2]; i++) {
+			if(TileStamps[(size_t)j * Grid->Size.x + i] == Stamp)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+// Mark a range of tiles as written during this resolve
+void _PhysicsStep::MarkChanged(const _Grid *Grid, const glm::ivec4 &Bounds) {
+	for(int j = Bounds[1]; j <= Bounds[3]; j++) {
+		for(int i = Bounds[0]; i <= Bounds[2]; i++)
+			TileStamps[(size_t)j * Grid->Size.x + i] = Stamp;
+	}
+}
@@ -0,0 +1,61 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <glm/vec4.hpp>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Forward Declarations
+class _Physics;
+class _Grid;
+class _WorkerPool;
+
+// Runs collision detection for many bodies in parallel, then resolves them serially in order.
+// Bodies whose detection read tiles changed by earlier bodies are detected again, so the result matches a sequential step.
+class _PhysicsStep {
+
+	public:
+
+		_PhysicsStep();
+
+		void Detect(const _Grid *Grid);
+		void Resolve(const _Grid *Grid);
+
+		// Attributes
+		std::vector<_Physics *> Bodies;
+		_WorkerPool *WorkerPool;
+
+		// Stats
+		double DetectTime;
+		double ResolveTime;
+		size_t RedetectCount;
+
+	private:
+
+		void DetectRange(const _Grid *Grid, size_t Start, size_t End);
+		bool IsChanged(const _Grid *Grid, const glm::ivec4 &Bounds) const;
+		void MarkChanged(const _Grid *Grid, const glm::ivec4 &Bounds);
+
+		// Tiles written during the current resolve
+		std::vector<uint32_t> TileStamps;
+		uint32_t Stamp;
+
+};
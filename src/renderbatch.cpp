@@ -0,0 +1,252 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <renderbatch.h>
+#include <ae/graphics.h>
+#include <ae/program.h>
+#include <ae/texture.h>
+#include <ae/mesh.h>
+#include <glm/vec2.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+// Constructor
+_RenderBatch::_RenderBatch() :
+	DrawCalls(0),
+	ProgramChanges(0),
+	VertexBufferID(0),
+	ElementBufferID(0),
+	ElementQuadCount(0) {
+
+}
+
+// Destructor
+_RenderBatch::~_RenderBatch() {
+	if(VertexBufferID)
+		glDeleteBuffers(1, &VertexBufferID);
+	if(ElementBufferID)
+		glDeleteBuffers(1, &ElementBufferID);
+}
+
+// Remove items from the previous layer
+void _RenderBatch::Clear() {
+	Items.clear();
+	Batches.clear();
+	Vertices.clear();
+}
+
+// Group items into batches, sorting by state first when draw order doesn't matter
+void _RenderBatch::Build(bool Sort) {
+	Batches.clear();
+	Vertices.clear();
+
+	// Items with equal state keep their order
+	if(Sort) {
+		std::less<const void *> Less;
+		std::stable_sort(Items.begin(), Items.end(), [&Less](const _DrawItem &Left, const _DrawItem &Right) {
+			if(Left.Program != Right.Program)
+				return Less(Left.Program, Right.Program);
+			if(Left.Texture != Right.Texture)
+				return Less(Left.Texture, Right.Texture);
+			if(Left.Mesh != Right.Mesh)
+				return Less(Left.Mesh, Right.Mesh);
+
+			return Left.Type < Right.Type;
+		});
+	}
+
+	for(size_t i = 0; i < Items.size(); i++) {
+		const _DrawItem &Item = Items[i];
+		if(!Batches.empty()) {
+			_DrawBatch &Batch = Batches.back();
+			const _DrawItem &First = Items[Batch.Start];
+			if(Batch.Type == Item.Type && Batch.Program == Item.Program && Batch.Texture == Item.Texture && Batch.Mesh == Item.Mesh
+				&& (!IsQuad(Item) || (First.Color == Item.Color && First.Position.z == Item.Position.z))) {
+				Batch.Count++;
+				continue;
+			}
+		}
+
+		Batches.push_back({ Item.Type, Item.Program, Item.Texture, Item.Mesh, i, 1, 0 });
+	}
+
+	// Build vertices for runs of quads, single quads are drawn directly
+	for(auto &Batch : Batches) {
+		if(!IsMerged(Batch))
+			continue;
+
+		Batch.QuadStart = GetQuadCount();
+		for(size_t i = Batch.Start; i < Batch.Start + Batch.Count; i++)
+			AddQuad(Items[i]);
+	}
+}
+
+// Get the number of draw calls submitting the batches will take
+int _RenderBatch::GetBatchDrawCalls() const {
+	int Count = 0;
+	for(const auto &Batch : Batches)
+		Count += IsMerged(Batch) ? 1 : (int)Batch.Count;
+
+	return Count;
+}
+
+// Draw batches, only switching programs and mesh buffers between batches
+void _RenderBatch::Submit() {
+	UploadQuads();
+
+	const ae::_Program *LastProgram = nullptr;
+	bool First = true;
+	for(const auto &Batch : Batches) {
+		if(First || Batch.Program != LastProgram) {
+			First = false;
+			ae::Graphics.SetProgram(Batch.Program);
+			LastProgram = Batch.Program;
+			ProgramChanges++;
+		}
+
+		if(Batch.Type == _DrawItem::MESH) {
+			SubmitMeshes(Batch);
+			continue;
+		}
+
+		if(IsMerged(Batch)) {
+			SubmitQuads(Batch);
+			continue;
+		}
+
+		for(size_t i = Batch.Start; i < Batch.Start + Batch.Count; i++)
+			SubmitItem(Items[i]);
+	}
+}
+
+// Append the corners of a sprite or animation frame in world space, laid out like floor tiles
+void _RenderBatch::AddQuad(const _DrawItem &Item) {
+	glm::vec4 Coords = Item.Type == _DrawItem::ANIMATION ? Item.TextureCoords : glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+	// Rotate the half size axes
+	float Radians = glm::radians(Item.Rotation);
+	glm::vec2 AxisX(std::cos(Radians), std::sin(Radians));
+	glm::vec2 AxisY(-AxisX.y, AxisX.x);
+	AxisX *= Item.Size.x * 0.5f;
+	AxisY *= Item.Size.y * 0.5f;
+
+	glm::vec2 Center(Item.Position);
+	glm::vec2 Corners[4] = {
+		Center - AxisX - AxisY,
+		Center + AxisX - AxisY,
+		Center - AxisX + AxisY,
+		Center + AxisX + AxisY,
+	};
+	Vertices.push_back({ Corners[0].x, Corners[0].y, Coords[0], Coords[1] });
+	Vertices.push_back({ Corners[1].x, Corners[1].y, Coords[2], Coords[1] });
+	Vertices.push_back({ Corners[2].x, Corners[2].y, Coords[0], Coords[3] });
+	Vertices.push_back({ Corners[3].x, Corners[3].y, Coords[2], Coords[3] });
+}
+
+// Upload merged quad vertices and grow the shared element buffer if needed
+void _RenderBatch::UploadQuads() {
+	if(Vertices.empty())
+		return;
+
+	if(!VertexBufferID)
+		glGenBuffers(1, &VertexBufferID);
+	ae::Graphics.SetVertexBufferID(VertexBufferID);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec4) * Vertices.size(), Vertices.data(), GL_STREAM_DRAW);
+
+	size_t QuadCount = GetQuadCount();
+	if(QuadCount <= ElementQuadCount)
+		return;
+
+	// Every quad uses the same layout
+	ElementQuadCount = std::max(QuadCount, ElementQuadCount * 2);
+	std::vector<glm::u32vec3> Faces;
+	Faces.reserve(2 * ElementQuadCount);
+	for(uint32_t VertexIndex = 0; VertexIndex < 4 * ElementQuadCount; VertexIndex += 4) {
+		Faces.push_back({ VertexIndex + 2, VertexIndex + 1, VertexIndex + 0 });
+		Faces.push_back({ VertexIndex + 2, VertexIndex + 3, VertexIndex + 1 });
+	}
+
+	if(!ElementBufferID)
+		glGenBuffers(1, &ElementBufferID);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ElementBufferID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(glm::u32vec3) * Faces.size(), Faces.data(), GL_STATIC_DRAW);
+}
+
+// Draw a run of sprites or animation frames with one call
+void _RenderBatch::SubmitQuads(const _DrawBatch &Batch) {
+	const _DrawItem &First = Items[Batch.Start];
+
+	ae::Graphics.SetColor(First.Color);
+	ae::Graphics.SetTextureID(Batch.Texture->ID);
+	ae::Graphics.SetVertexBufferID(VertexBufferID);
+	ae::Graphics.EnableAttribs(2);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)sizeof(glm::vec2));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ElementBufferID);
+
+	// Vertices are in world space, only depth comes from the transform
+	glUniformMatrix4fv(Batch.Program->ModelTransformID, 1, GL_FALSE, glm::value_ptr(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, First.Position.z))));
+	glUniformMatrix4fv(Batch.Program->TextureTransformID, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+	glDrawElements(GL_TRIANGLES, (GLsizei)(Batch.Count * 6), GL_UNSIGNED_INT, (void *)(Batch.QuadStart * 6 * sizeof(uint32_t)));
+	DrawCalls++;
+}
+
+// Bind a mesh once and draw every item using it
+void _RenderBatch::SubmitMeshes(const _DrawBatch &Batch) {
+	const ae::_Mesh *Mesh = Batch.Mesh;
+
+	ae::Graphics.SetTextureID(Batch.Texture->ID);
+	ae::Graphics.SetVertexBufferID(Mesh->VertexBufferID);
+	ae::Graphics.EnableAttribs(3);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ae::_PackedVertex), ae::_PackedVertex::GetPositionOffset());
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ae::_PackedVertex), ae::_PackedVertex::GetUVOffset());
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(ae::_PackedVertex), ae::_PackedVertex::GetNormalOffset());
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Mesh->ElementBufferID);
+
+	for(size_t i = Batch.Start; i < Batch.Start + Batch.Count; i++) {
+		const _DrawItem &Item = Items[i];
+		ae::Graphics.SetColor(Item.Color);
+		glUniformMatrix4fv(Batch.Program->ModelTransformID, 1, GL_FALSE, glm::value_ptr(glm::translate(glm::mat4(1.0f), Item.Position)));
+		glDrawElements(GL_TRIANGLES, Mesh->IndexCount, GL_UNSIGNED_INT, 0);
+		DrawCalls++;
+	}
+}
+
+// Draw a single sprite, animation frame, cube or rectangle
+void _RenderBatch::SubmitItem(const _DrawItem &Item) {
+	ae::Graphics.SetColor(Item.Color);
+	switch(Item.Type) {
+		case _DrawItem::ANIMATION:
+			ae::Graphics.DrawAnimationFrame(Item.Position, Item.Texture, Item.TextureCoords, Item.Rotation, glm::vec2(Item.Size));
+		break;
+		case _DrawItem::SPRITE:
+			ae::Graphics.DrawSprite(Item.Position, Item.Texture, Item.Rotation, glm::vec2(Item.Size));
+		break;
+		case _DrawItem::CUBE:
+			ae::Graphics.DrawCube(Item.Position, Item.Size, Item.Texture);
+		break;
+		case _DrawItem::RECTANGLE:
+			ae::Graphics.DrawRectangle3D(glm::vec2(Item.Position), glm::vec2(Item.Position + Item.Size), true);
+		break;
+	}
+
+	DrawCalls++;
+}
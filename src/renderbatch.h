@@ -0,0 +1,111 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Forward Declarations
+namespace ae {
+	class _Program;
+	class _Texture;
+	class _Mesh;
+}
+
+// Draw request collected from a render component
+struct _DrawItem {
+
+	enum DrawType {
+		MESH,
+		ANIMATION,
+		SPRITE,
+		CUBE,
+		RECTANGLE,
+	};
+
+	int Type;
+	const ae::_Program *Program;
+	const ae::_Texture *Texture;
+	const ae::_Mesh *Mesh;
+	glm::vec4 Color;
+	glm::vec4 TextureCoords;
+	glm::vec3 Position;
+	glm::vec3 Size;
+	float Rotation;
+};
+
+// Run of draw items that share a program, texture and mesh, sprites and animation frames in a run also share a color and depth
+struct _DrawBatch {
+	int Type;
+	const ae::_Program *Program;
+	const ae::_Texture *Texture;
+	const ae::_Mesh *Mesh;
+	size_t Start;
+	size_t Count;
+	size_t QuadStart;
+};
+
+// Collects draw items for a layer and submits them grouped by state
+class _RenderBatch {
+
+	public:
+
+		_RenderBatch();
+		~_RenderBatch();
+
+		void Clear();
+		void Add(const _DrawItem &Item) { Items.push_back(Item); }
+
+		// Building only touches the cpu, submitting uploads merged quads and issues the draws
+		void Build(bool Sort=true);
+		void Submit();
+
+		const std::vector<_DrawItem> &GetItems() const { return Items; }
+		const std::vector<_DrawBatch> &GetBatches() const { return Batches; }
+		size_t GetQuadCount() const { return Vertices.size() / 4; }
+		int GetBatchDrawCalls() const;
+
+		// Stats
+		void ResetStats() { DrawCalls = ProgramChanges = 0; }
+		int DrawCalls;
+		int ProgramChanges;
+
+	private:
+
+		static bool IsQuad(const _DrawItem &Item) { return Item.Type == _DrawItem::SPRITE || Item.Type == _DrawItem::ANIMATION; }
+		bool IsMerged(const _DrawBatch &Batch) const { return Batch.Count > 1 && IsQuad(Items[Batch.Start]); }
+		void AddQuad(const _DrawItem &Item);
+		void UploadQuads();
+		void SubmitMeshes(const _DrawBatch &Batch);
+		void SubmitQuads(const _DrawBatch &Batch);
+		void SubmitItem(const _DrawItem &Item);
+
+		std::vector<_DrawItem> Items;
+		std::vector<_DrawBatch> Batches;
+
+		// Merged quads
+		std::vector<glm::vec4> Vertices;
+		uint32_t VertexBufferID;
+		uint32_t ElementBufferID;
+		size_t ElementQuadCount;
+
+};
@@ -17,22 +17,75 @@
 *******************************************************************************/
 #include <scripting.h>
 #include <objects/object.h>
+#include <objects/physics.h>
+#include <objects/health.h>
+#include <ae/manager.h>
+#include <ae/log.h>
 #include <server.h>
+#include <map.h>
+#include <grid.h>
+#include <arena.h>
+#include <stats.h>
+#include <constants.h>
 #include <stdexcept>
+#include <chrono>
+
+// Registry keys
+static const char *SCRIPTING_KEY = "esdf.scripting";
+static const char *OBJECT_METATABLE = "esdf.object";
+static const char *MAP_METATABLE = "esdf.map";
+static const char *SERVER_METATABLE = "esdf.server";
+
+// Object reference stored in lua userdata
+struct _ScriptObject {
+	_Handle Handle;
+	ae::NetworkIDType MapID;
+};
+
+std::unordered_map<std::string, std::string> _Scripting::ChunkCache;
+std::mutex _Scripting::ChunkCacheMutex;
 
 // Constructor
 _Scripting::_Scripting() :
 	Server(nullptr),
-	LuaState(nullptr) {
+	Log(nullptr),
+	LuaState(nullptr),
+	CurrentObject(nullptr),
+	InstructionCount(0) {
 
 	// Initialize lua object
 	LuaState = luaL_newstate();
 	luaopen_base(LuaState);
 	luaopen_math(LuaState);
 
-	// Set globals
+	// Store pointer for C++ functions
 	lua_pushlightuserdata(LuaState, this);
-	lua_setglobal(LuaState, "param_scripting");
+	lua_setfield(LuaState, LUA_REGISTRYINDEX, SCRIPTING_KEY);
+
+	// Register userdata types
+	static const luaL_Reg ObjectMethods[] = {
+		{ "id", &ObjectIDFunction },
+		{ "identifier", &ObjectIdentifierFunction },
+		{ "position", &ObjectPositionFunction },
+		{ "health", &ObjectHealthFunction },
+		{ "map", &ObjectMapFunction },
+		{ nullptr, nullptr }
+	};
+	static const luaL_Reg MapMethods[] = {
+		{ "name", &MapNameFunction },
+		{ "query", &MapQueryFunction },
+		{ "spawn", &MapSpawnFunction },
+		{ nullptr, nullptr }
+	};
+	static const luaL_Reg ServerMethods[] = {
+		{ "time", &ServerTimeFunction },
+		{ "map", &ServerMapFunction },
+		{ "change_map", &ServerChangeMapFunction },
+		{ nullptr, nullptr }
+	};
+	RegisterType(OBJECT_METATABLE, ObjectMethods);
+	RegisterType(MAP_METATABLE, MapMethods);
+	RegisterType(SERVER_METATABLE, ServerMethods);
 
 	// Register C++ functions used by lua
 	lua_register(LuaState, "map_change", &MapChangeFunction);
@@ -41,45 +94,374 @@ _Scripting::_Scripting() :
 // Destructor
 _Scripting::~_Scripting() {
 
+	// Write script costs to the log
+	if(Log) {
+		for(auto &ScriptStat : ScriptStats) {
+			if(ScriptStat.second.CallCount)
+				*Log << "Script calls=" << ScriptStat.second.CallCount << " aborts=" << ScriptStat.second.AbortCount << " time=" << ScriptStat.second.Time << " name=" << ScriptStat.second.Name << std::endl;
+		}
+	}
+
 	// Close lua state
 	if(LuaState != nullptr)
 		lua_close(LuaState);
 }
 
-// Load a script file
+// Load a script file, reusing bytecode compiled by other maps
 void _Scripting::LoadScript(const std::string &Path) {
+	{
+		std::lock_guard<std::mutex> Lock(ChunkCacheMutex);
+
+		auto Iterator = ChunkCache.find(Path);
+		if(Iterator != ChunkCache.end()) {
+			if(luaL_loadbuffer(LuaState, Iterator->second.data(), Iterator->second.size(), Path.c_str()) != 0)
+				throw std::runtime_error("Failed to load script " + Path + "\n" + std::string(lua_tostring(LuaState, -1)));
+		}
+		else {
+
+			// Compile the file and cache its bytecode
+			if(luaL_loadfile(LuaState, Path.c_str()) != 0)
+				throw std::runtime_error("Failed to load script " + Path + "\n" + std::string(lua_tostring(LuaState, -1)));
 
-	// Load the file
-	if(luaL_dofile(LuaState, Path.c_str()) != 0)
+			std::string &Bytecode = ChunkCache[Path];
+			lua_dump(LuaState, DumpWriter, &Bytecode);
+		}
+	}
+
+	// Run the chunk
+	if(lua_pcall(LuaState, 0, 0, 0) != 0)
 		throw std::runtime_error("Failed to load script " + Path + "\n" + std::string(lua_tostring(LuaState, -1)));
 }
 
-// Execute lua code
-void _Scripting::ExecuteLua(const std::string &Code, _Object *Object) {
-	lua_pushlightuserdata(LuaState, Object);
-	lua_setglobal(LuaState, "param_object");
+// Compile lua code into a function stored in the registry, returns LUA_NOREF for empty code
+int _Scripting::CompileLua(const std::string &Code) {
+	if(Code == "")
+		return LUA_NOREF;
+
+	if(luaL_loadstring(LuaState, Code.c_str()) != 0)
+		throw std::runtime_error("Failed to compile " + Code + "\n" + std::string(lua_tostring(LuaState, -1)));
+
+	int Reference = luaL_ref(LuaState, LUA_REGISTRYINDEX);
+	ScriptStats[Reference].Name = Code;
+
+	return Reference;
+}
+
+// Get a reference to a global function, returns LUA_NOREF if it isn't defined
+int _Scripting::GetFunctionReference(const std::string &Name) {
+	lua_getglobal(LuaState, Name.c_str());
+	if(!lua_isfunction(LuaState, -1)) {
+		lua_pop(LuaState, 1);
+		return LUA_NOREF;
+	}
+
+	int Reference = luaL_ref(LuaState, LUA_REGISTRYINDEX);
+	ScriptStats[Reference].Name = Name;
+
+	return Reference;
+}
+
+// Free a compiled function
+void _Scripting::ReleaseLua(int Reference) {
+	if(Reference == LUA_NOREF)
+		return;
+
+	luaL_unref(LuaState, LUA_REGISTRYINDEX, Reference);
+	ScriptStats.erase(Reference);
+}
+
+// Execute a queued event from a map, passing (object, other, value) to the compiled function
+void _Scripting::ExecuteEvent(const _ScriptEvent &Event, _Map *Map) {
+	if(Event.Reference == LUA_NOREF)
+		return;
+
+	// Objects may have been deleted since the event was queued
+	_Object *Object = Map->GetObject(Event.Object);
+	if(Object)
+		Object->Wake();
+
+	// Run with an instruction budget
+	auto StartTime = std::chrono::steady_clock::now();
+	CurrentObject = Object;
+	InstructionCount = 0;
+	lua_sethook(LuaState, InstructionHook, LUA_MASKCOUNT, SCRIPT_HOOK_INTERVAL);
+	lua_rawgeti(LuaState, LUA_REGISTRYINDEX, Event.Reference);
+	PushObject(LuaState, Event.Object, Map);
+	if(Event.Other.IsValid())
+		PushObject(LuaState, Event.Other, Map);
+	else
+		lua_pushnil(LuaState);
+	lua_pushinteger(LuaState, Event.Value);
+	int ReturnCode = lua_pcall(LuaState, 3, 0, 0);
+	lua_sethook(LuaState, nullptr, 0, 0);
+	CurrentObject = nullptr;
+
+	// Update stats
+	_ScriptStat &ScriptStat = ScriptStats[Event.Reference];
+	ScriptStat.CallCount++;
+	ScriptStat.Time += std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+	// Abort the script without stopping the server
+	if(ReturnCode) {
+		ScriptStat.AbortCount++;
+		if(Log)
+			*Log << "Script aborted: " << ScriptStat.Name << " error=" << lua_tostring(LuaState, -1) << std::endl;
+		lua_pop(LuaState, 1);
+	}
+}
+
+// Set server, log to it and expose it to scripts
+void _Scripting::SetServer(_Server *Server) {
+	this->Server = Server;
+	Log = &Server->Log;
+
+	_Server **Userdata = (_Server **)lua_newuserdata(LuaState, sizeof(_Server *));
+	*Userdata = Server;
+	luaL_getmetatable(LuaState, SERVER_METATABLE);
+	lua_setmetatable(LuaState, -2);
+	lua_setglobal(LuaState, "server");
+}
+
+// Create a metatable in the registry with methods for a userdata type
+void _Scripting::RegisterType(const char *Name, const luaL_Reg *Methods) {
+	luaL_newmetatable(LuaState, Name);
+	lua_newtable(LuaState);
+	luaL_setfuncs(LuaState, Methods, 0);
+	lua_setfield(LuaState, -2, "__index");
+	lua_pop(LuaState, 1);
+}
+
+// Get scripting pointer from the registry
+_Scripting *_Scripting::GetScripting(lua_State *LuaState) {
+	lua_getfield(LuaState, LUA_REGISTRYINDEX, SCRIPTING_KEY);
+	_Scripting *Scripting = (_Scripting *)lua_topointer(LuaState, -1);
+	lua_pop(LuaState, 1);
+
+	return Scripting;
+}
+
+// Push an object handle, objects are resolved through their map so stale handles are detected
+void _Scripting::PushObject(lua_State *LuaState, const _Handle &Handle, const _Map *Map) {
+	_ScriptObject *Userdata = (_ScriptObject *)lua_newuserdata(LuaState, sizeof(_ScriptObject));
+	Userdata->Handle = Handle;
+	Userdata->MapID = Map->NetworkID;
+	luaL_getmetatable(LuaState, OBJECT_METATABLE);
+	lua_setmetatable(LuaState, -2);
+}
+
+// Push a map handle
+void _Scripting::PushMap(lua_State *LuaState, const _Map *Map) {
+	ae::NetworkIDType *Userdata = (ae::NetworkIDType *)lua_newuserdata(LuaState, sizeof(ae::NetworkIDType));
+	*Userdata = Map->NetworkID;
+	luaL_getmetatable(LuaState, MAP_METATABLE);
+	lua_setmetatable(LuaState, -2);
+}
+
+// Get object from a handle argument
+_Object *_Scripting::CheckObject(lua_State *LuaState, int Index) {
+	const _ScriptObject *Userdata = (const _ScriptObject *)luaL_checkudata(LuaState, Index, OBJECT_METATABLE);
+	_Scripting *Scripting = GetScripting(LuaState);
+	if(!Scripting->Server)
+		luaL_error(LuaState, "objects are only available on the server");
+
+	_Map *Map = Scripting->Server->MapManager->GetObject(Userdata->MapID);
+	_Object *Object = Map ? Map->GetObject(Userdata->Handle) : nullptr;
+	if(!Object || Object->Deleted)
+		luaL_error(LuaState, "object no longer exists");
+
+	return Object;
+}
+
+// Get map from a handle argument
+_Map *_Scripting::CheckMap(lua_State *LuaState, int Index) {
+	ae::NetworkIDType ID = *(ae::NetworkIDType *)luaL_checkudata(LuaState, Index, MAP_METATABLE);
+	_Scripting *Scripting = GetScripting(LuaState);
+	if(!Scripting->Server)
+		luaL_error(LuaState, "maps are only available on the server");
+
+	_Map *Map = Scripting->Server->MapManager->GetObject(ID);
+	if(!Map)
+		luaL_error(LuaState, "map %d no longer exists", (int)ID);
+
+	return Map;
+}
+
+// Get server from a handle argument
+_Server *_Scripting::CheckServer(lua_State *LuaState, int Index) {
+	return *(_Server **)luaL_checkudata(LuaState, Index, SERVER_METATABLE);
+}
+
+// object:id()
+int _Scripting::ObjectIDFunction(lua_State *LuaState) {
+	_Object *Object = CheckObject(LuaState, 1);
+	lua_pushinteger(LuaState, Object->NetworkID);
 
-	int ReturnCode = luaL_dostring(LuaState, Code.c_str());
-	if(ReturnCode)
-		throw std::runtime_error(lua_tostring(LuaState, -1));
+	return 1;
 }
 
-// Change maps
+// object:identifier()
+int _Scripting::ObjectIdentifierFunction(lua_State *LuaState) {
+	_Object *Object = CheckObject(LuaState, 1);
+	lua_pushstring(LuaState, Object->Identifier.c_str());
+
+	return 1;
+}
+
+// object:position() returns x, y
+int _Scripting::ObjectPositionFunction(lua_State *LuaState) {
+	_Object *Object = CheckObject(LuaState, 1);
+	if(!Object->Physics)
+		return 0;
+
+	lua_pushnumber(LuaState, Object->Physics->Position.x);
+	lua_pushnumber(LuaState, Object->Physics->Position.y);
+
+	return 2;
+}
+
+// object:health() returns health, max health
+int _Scripting::ObjectHealthFunction(lua_State *LuaState) {
+	_Object *Object = CheckObject(LuaState, 1);
+	auto Iterator = Object->Components.find("health");
+	if(Iterator == Object->Components.end())
+		return 0;
+
+	_Health *Health = (_Health *)Iterator->second;
+	lua_pushinteger(LuaState, Health->Health);
+	lua_pushinteger(LuaState, Health->MaxHealth);
+
+	return 2;
+}
+
+// object:map()
+int _Scripting::ObjectMapFunction(lua_State *LuaState) {
+	_Object *Object = CheckObject(LuaState, 1);
+	if(!Object->Map)
+		return 0;
+
+	PushMap(LuaState, Object->Map);
+
+	return 1;
+}
+
+// map:name()
+int _Scripting::MapNameFunction(lua_State *LuaState) {
+	_Map *Map = CheckMap(LuaState, 1);
+	lua_pushstring(LuaState, Map->Filename.c_str());
+
+	return 1;
+}
+
+// map:query(x, y, radius) returns a list of objects
+int _Scripting::MapQueryFunction(lua_State *LuaState) {
+	_Map *Map = CheckMap(LuaState, 1);
+	glm::vec2 Position(luaL_checknumber(LuaState, 2), luaL_checknumber(LuaState, 3));
+	float Radius = (float)luaL_checknumber(LuaState, 4);
+
+	// Query grid
+	_ArenaVector<_Object *> Objects(FrameArena);
+	Map->QueryObjects(Position, Radius, Objects);
+
+	// Build table
+	lua_createtable(LuaState, (int)Objects.Size(), 0);
+	for(size_t i = 0; i < Objects.Size(); i++) {
+		PushObject(LuaState, Objects[i]->Handle, Map);
+		lua_rawseti(LuaState, -2, (int)i + 1);
+	}
+
+	return 1;
+}
+
+// map:spawn(identifier, x, y) returns the new object
+int _Scripting::MapSpawnFunction(lua_State *LuaState) {
+	_Map *Map = CheckMap(LuaState, 1);
+	const char *Identifier = luaL_checkstring(LuaState, 2);
+	glm::vec2 Position(luaL_checknumber(LuaState, 3), luaL_checknumber(LuaState, 4));
+
+	// Create object
+	_Server *Server = GetScripting(LuaState)->Server;
+	_Object *Object = Server->ObjectManager->Create();
+	Server->Stats->CreateObject(Object, Identifier, true);
+	if(Object->Identifier.empty()) {
+		Object->Deleted = true;
+		return luaL_error(LuaState, "unknown object identifier %s", Identifier);
+	}
+
+	// Add to map
+	if(Object->Physics)
+		Object->Physics->ForcePosition(Position);
+	Map->AddObject(Object);
+	if(Object->Physics)
+		Map->Grid->AddObject(Object);
+
+	PushObject(LuaState, Object->Handle, Map);
+
+	return 1;
+}
+
+// server:time()
+int _Scripting::ServerTimeFunction(lua_State *LuaState) {
+	_Server *Server = CheckServer(LuaState, 1);
+	lua_pushnumber(LuaState, Server->Time);
+
+	return 1;
+}
+
+// server:map(name) returns a loaded or newly loaded map
+int _Scripting::ServerMapFunction(lua_State *LuaState) {
+	_Server *Server = CheckServer(LuaState, 1);
+	_Map *Map = Server->GetMap(luaL_checkstring(LuaState, 2));
+	if(!Map)
+		return 0;
+
+	PushMap(LuaState, Map);
+
+	return 1;
+}
+
+// server:change_map(object, map_name)
+int _Scripting::ServerChangeMapFunction(lua_State *LuaState) {
+	_Server *Server = CheckServer(LuaState, 1);
+	_Object *Object = CheckObject(LuaState, 2);
+	const char *MapName = luaL_checkstring(LuaState, 3);
+	if(!Object->Peer)
+		return luaL_error(LuaState, "only players can change maps");
+
+	Server->ChangePlayerMap(MapName, Object->Peer);
+
+	return 0;
+}
+
+// Stop scripts that run past the instruction budget
+void _Scripting::InstructionHook(lua_State *LuaState, lua_Debug *Debug) {
+	_Scripting *Scripting = GetScripting(LuaState);
+	Scripting->InstructionCount += SCRIPT_HOOK_INTERVAL;
+	if(Scripting->InstructionCount > SCRIPT_INSTRUCTION_BUDGET)
+		luaL_error(LuaState, "instruction budget of %d exceeded", SCRIPT_INSTRUCTION_BUDGET);
+}
+
+// Append dumped bytecode to a string
+int _Scripting::DumpWriter(lua_State *LuaState, const void *Data, size_t Size, void *UserData) {
+	std::string *Bytecode = (std::string *)UserData;
+	Bytecode->append((const char *)Data, Size);
+
+	return 0;
+}
+
+// Change maps for the object that triggered the script
 int _Scripting::MapChangeFunction(lua_State *LuaState) {
 	int ArgumentCount = lua_gettop(LuaState);
 	if(ArgumentCount != 1)
-		throw std::runtime_error("Wrong argument count for function map_change(map)");
+		return luaL_error(LuaState, "Wrong argument count for function map_change(map)");
 
 	// Get parameters
-	std::string Map = lua_tostring(LuaState, 1);
+	const char *Map = luaL_checkstring(LuaState, 1);
 
 	// Get object
-	lua_getglobal(LuaState, "param_object");
-	_Object *Object = (_Object *)lua_topointer(LuaState, -1);
-
-	// Get scripting pointer
-	lua_getglobal(LuaState, "param_scripting");
-	_Scripting *Scripting = (_Scripting *)lua_topointer(LuaState, -1);
+	_Scripting *Scripting = GetScripting(LuaState);
+	_Object *Object = Scripting->CurrentObject;
+	if(!Scripting->Server || !Object || !Object->Peer)
+		return luaL_error(LuaState, "map_change can only be called by players on the server");
 
 	// Change maps
 	Scripting->Server->ChangePlayerMap(Map, Object->Peer);
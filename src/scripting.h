@@ -19,11 +19,31 @@
 
 // Libraries
 #include <string>
+#include <unordered_map>
+#include <mutex>
+#include <ae/type.h>
 #include <lua.hpp>
 
 // Forward Declarations
 class _Object;
+class _Map;
 class _Server;
+struct _ScriptEvent;
+struct _Handle;
+
+namespace ae {
+	class _LogFile;
+}
+
+// Cost of a compiled script
+struct _ScriptStat {
+	_ScriptStat() : CallCount(0), AbortCount(0), Time(0.0) { }
+
+	std::string Name;
+	int CallCount;
+	int AbortCount;
+	double Time;
+};
 
 // Classes
 class _Scripting {
@@ -35,14 +55,57 @@ class _Scripting {
 
 		void LoadScript(const std::string &Path);
 
-		void ExecuteLua(const std::string &Code, _Object *Object);
+		int CompileLua(const std::string &Code);
+		int GetFunctionReference(const std::string &Name);
+		void ReleaseLua(int Reference);
+		void ExecuteEvent(const _ScriptEvent &Event, _Map *Map);
+
+		void SetServer(_Server *Server);
+		const std::unordered_map<int, _ScriptStat> &GetScriptStats() const { return ScriptStats; }
 
 		_Server *Server;
+		ae::_LogFile *Log;
 
 	private:
 
+		void RegisterType(const char *Name, const luaL_Reg *Methods);
+
+		// Userdata
+		static _Scripting *GetScripting(lua_State *LuaState);
+		static void PushObject(lua_State *LuaState, const _Handle &Handle, const _Map *Map);
+		static void PushMap(lua_State *LuaState, const _Map *Map);
+		static _Object *CheckObject(lua_State *LuaState, int Index);
+		static _Map *CheckMap(lua_State *LuaState, int Index);
+		static _Server *CheckServer(lua_State *LuaState, int Index);
+
+		// Object functions
+		static int ObjectIDFunction(lua_State *LuaState);
+		static int ObjectIdentifierFunction(lua_State *LuaState);
+		static int ObjectPositionFunction(lua_State *LuaState);
+		static int ObjectHealthFunction(lua_State *LuaState);
+		static int ObjectMapFunction(lua_State *LuaState);
+
+		// Map functions
+		static int MapNameFunction(lua_State *LuaState);
+		static int MapQueryFunction(lua_State *LuaState);
+		static int MapSpawnFunction(lua_State *LuaState);
+
+		// Server functions
+		static int ServerTimeFunction(lua_State *LuaState);
+		static int ServerMapFunction(lua_State *LuaState);
+		static int ServerChangeMapFunction(lua_State *LuaState);
+
+		static void InstructionHook(lua_State *LuaState, lua_Debug *Debug);
+		static int DumpWriter(lua_State *LuaState, const void *Data, size_t Size, void *UserData);
 		static int MapChangeFunction(lua_State *LuaState);
 
+		// Compiled script files shared by all maps
+		static std::unordered_map<std::string, std::string> ChunkCache;
+		static std::mutex ChunkCacheMutex;
+
+		std::unordered_map<int, _ScriptStat> ScriptStats;
 		lua_State *LuaState;
+		_Object *CurrentObject;
+		int InstructionCount;
 
 };
@@ -17,7 +17,6 @@
 *******************************************************************************/
 #include <server.h>
 #include <ae/network.h>
-#include <ae/servernetwork.h>
 #include <ae/peer.h>
 #include <ae/manager.h>
 #include <ae/buffer.h>
@@ -29,10 +28,19 @@
 #include <packet.h>
 #include <map.h>
 #include <grid.h>
+#include <aischeduler.h>
+#include <physicsstep.h>
+#include <workerpool.h>
+#include <arena.h>
 #include <stats.h>
+#include <journal.h>
+#include <transport.h>
 #include <constants.h>
 #include <config.h>
 #include <SDL_timer.h>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
 
 // Function to run the server thread
 void RunThread(void *Arguments) {
@@ -60,28 +68,34 @@ void RunThread(void *Arguments) {
 	}
 }
 
-// Constructor
+// Constructor for a server listening on a UDP port
 _Server::_Server(uint16_t NetworkPort) :
+	_Server(new _ENetServerTransport(Config.MaxClients, NetworkPort)) {
+}
+
+// Constructor, takes ownership of the network
+_Server::_Server(_ServerTransport *Network) :
 	Done(false),
 	StartDisconnect(false),
 	StartShutdown(false),
 	TimeSteps(0),
 	Time(0.0),
+	HashLevel(0),
+	Replaying(false),
 	Stats(nullptr),
-	Network(new ae::_ServerNetwork(64, NetworkPort)),
+	Network(Network),
 	Thread(nullptr) {
 
-	if(!Network->HasConnection())
-		throw std::runtime_error("Unable to bind address!");
-
-	Network->SetFakeLag(Config.FakeLag);
-	Network->SetUpdatePeriod(Config.NetworkRate);
+	this->Network->SetFakeLag(Config.FakeLag);
+	this->Network->SetUpdatePeriod(Config.NetworkRate);
 	Log.Open((Config.ConfigPath + "server.log").c_str());
 	//Log.SetToStdOut(true);
 
 	Stats = new _Stats();
+	StringTable.Build(Stats);
 	MapManager = new ae::_Manager<_Map>();
 	ObjectManager = new ae::_Manager<_Object>();
+	PhysicsWorkers.reset(new _WorkerPool(std::max(1, (int)std::thread::hardware_concurrency())));
 }
 
 // Destructor
@@ -113,6 +127,83 @@ void _Server::StopServer() {
 	StartDisconnect = true;
 }
 
+// Record every incoming event to a journal
+bool _Server::StartRecording(const std::string &Path) {
+	Journal.reset(new _Journal());
+	if(!Journal->OpenWrite(Path)) {
+		Journal.reset();
+		return false;
+	}
+
+	return true;
+}
+
+// Feed a recorded journal through the server as fast as possible
+bool _Server::Replay(const std::string &Path) {
+	_Journal Playback;
+	if(!Playback.OpenRead(Path))
+		return false;
+
+	// Journal peers have no connection, so packets sent to them are dropped
+	Replaying = true;
+	std::unordered_map<uint32_t, ae::_Peer *> Peers;
+	_Journal::_Record Record;
+	ae::_NetworkEvent Event;
+	uint32_t Ticks = 0;
+	uint32_t Packets = 0;
+	double UpdateTime = 0.0;
+	auto StartTime = std::chrono::steady_clock::now();
+	while(Playback.ReadRecord(Record)) {
+		switch(Record.Type) {
+			case _Journal::TICK: {
+				auto UpdateStart = std::chrono::steady_clock::now();
+				Update(Record.FrameTime);
+				UpdateTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - UpdateStart).count();
+				Ticks++;
+			} break;
+			case _Journal::CONNECT:
+				Event.Type = ae::_NetworkEvent::CONNECT;
+				Event.Peer = new ae::_Peer(nullptr);
+				Peers[Record.PeerID] = Event.Peer;
+				HandleConnect(Event);
+			break;
+			case _Journal::DISCONNECT: {
+				auto Iterator = Peers.find(Record.PeerID);
+				if(Iterator == Peers.end())
+					break;
+
+				RemovePlayer(Iterator->second);
+				delete Iterator->second;
+				Peers.erase(Iterator);
+			} break;
+			case _Journal::PACKET: {
+				auto Iterator = Peers.find(Record.PeerID);
+				if(Iterator == Peers.end() || Record.Data.empty())
+					break;
+
+				ae::_Buffer Data(Record.Data.data(), (unsigned int)Record.Data.size());
+				HandlePacket(&Data, Iterator->second);
+				Packets++;
+			} break;
+			case _Journal::MAP:
+				GetMap(std::string(Record.Data.begin(), Record.Data.end()));
+			break;
+		}
+	}
+
+	// Remove peers that were still connected when recording stopped
+	for(auto &Iterator : Peers) {
+		RemovePlayer(Iterator.second);
+		delete Iterator.second;
+	}
+
+	Replaying = false;
+	double TotalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+	Log << "Replay ticks=" << Ticks << " packets=" << Packets << " bytes=" << Playback.GetBytes() << " time=" << TotalTime << " update_time=" << UpdateTime << " update_avg=" << (Ticks ? UpdateTime / Ticks : 0.0) << std::endl;
+
+	return true;
+}
+
 // Update
 void _Server::Update(double FrameTime) {
 	//Log << "ServerUpdate " << TimeSteps << std::endl;
@@ -123,6 +214,8 @@ void _Server::Update(double FrameTime) {
 	// Get events
 	ae::_NetworkEvent NetworkEvent;
 	while(Network->GetNetworkEvent(NetworkEvent)) {
+		if(Journal)
+			Journal->WriteEvent(NetworkEvent);
 
 		switch(NetworkEvent.Type) {
 			case ae::_NetworkEvent::CONNECT:
@@ -138,44 +231,73 @@ void _Server::Update(double FrameTime) {
 		}
 	}
 
-	// Run player inputs
-	auto &Peers = Network->GetPeers();
-	for(auto &Peer : Peers) {
-		_Object *Player = Peer->Object;
-		if(Player && Player->HasComponent("controller")) {
-			_Controller *Controller = (_Controller *)Player->Components["controller"];
-
-			auto &InputHistory = Controller->History;
-			if(InputHistory.IsEmpty()) {
-				//Log << "StarvedInput= " << Player->GetID() << std::endl
-				break;
-			}
-
-			int InputsToPlay = 1;
-			if(InputHistory.Size() > 3)
-				InputsToPlay = 3;
-
-			while(InputsToPlay) {
-				auto &InputState = InputHistory.Front();
-				Controller->HandleInput(InputState);
-				Player->Physics->Update(FrameTime);
-				Player->SendUpdate = true;
-				Controller->LastInputTime = InputState.Time;
-				//Player->Map->CheckEvents(Player, this);
-				InputHistory.Pop();
-				InputsToPlay--;
-
-				//Log << "PlayerInputCount= " << InputHistory.Size() << std::endl;
+	// Run player inputs, peers are taken from the maps so replayed peers are included
+	for(auto &Map : MapManager->Objects) {
+		if(Map->Deleted)
+			continue;
+
+		for(auto &Peer : Map->GetPeers()) {
+			_Object *Player = Peer->Object;
+			if(Player && Player->HasComponent("controller")) {
+				_Controller *Controller = (_Controller *)Player->Components["controller"];
+
+				auto &InputHistory = Controller->History;
+				if(InputHistory.IsEmpty()) {
+					//Log << "StarvedInput= " << Player->GetID() << std::endl
+					break;
+				}
+
+				int InputsToPlay = 1;
+				if(InputHistory.Size() > 3)
+					InputsToPlay = 3;
+
+				while(InputsToPlay) {
+					auto &InputState = InputHistory.Front();
+					Controller->HandleInput(InputState);
+					Player->Physics->Update(FrameTime);
+					Player->SendUpdate = true;
+					Controller->LastInputTime = InputState.Time;
+					//Player->Map->CheckEvents(Player, this);
+					InputHistory.Pop();
+					InputsToPlay--;
+
+					//Log << "PlayerInputCount= " << InputHistory.Size() << std::endl;
+				}
 			}
 		}
 	}
 
+	// Run ai thinking for each map
+	for(auto &Map : MapManager->Objects) {
+		if(!Map->Deleted && Map->AiScheduler)
+			Map->AiScheduler->Update(FrameTime, Map->GetPeers());
+	}
+
+	// Run physics for each map
+	for(auto &Map : MapManager->Objects) {
+		if(!Map->Deleted)
+			Map->UpdatePhysics(FrameTime);
+	}
+
 	// Update objects
 	ObjectManager->Update(FrameTime);
 
 	// Update maps
 	MapManager->Update(FrameTime);
 
+	// Run script events queued during the simulation, then remove destroyed objects
+	for(auto &Map : MapManager->Objects) {
+		if(Map->Deleted)
+			continue;
+
+		Map->DispatchScriptEvents();
+		Map->DestroyQueuedObjects();
+	}
+
+	// Log state checksums so runs can be compared tick by tick
+	if(HashLevel)
+		LogStateHashes();
+
 	// Check if updates should be sent
 	if(Network->NeedsUpdate()) {
 		//Log << "NeedsUpdate " << TimeSteps << std::endl;
@@ -183,11 +305,12 @@ void _Server::Update(double FrameTime) {
 		if(0 && (rand() % 10) == 0) {
 			//printf("droppin pack\n");
 		}
-		else if(Network->GetPeers().size() > 0) {
+		else {
 
 			// Notify
 			for(auto &Map : MapManager->Objects) {
-				Map->SendObjectUpdates(TimeSteps);
+				if(!Map->Deleted && Map->GetPeers().size() > 0)
+					Map->SendObjectUpdates(TimeSteps);
 			}
 		}
 	}
@@ -202,34 +325,72 @@ void _Server::Update(double FrameTime) {
 		Done = true;
 	}
 
+	if(Journal)
+		Journal->WriteTick(FrameTime);
+
 	TimeSteps++;
 	Time += FrameTime;
+
+	// Free temporary allocations
+	FrameArena.Reset();
+}
+
+// Log a checksum of each map, followed by one per object when HashLevel > 1
+void _Server::LogStateHashes() {
+	std::vector<_ObjectHash> ObjectHashes;
+	for(auto &Map : MapManager->Objects) {
+		if(Map->Deleted)
+			continue;
+
+		uint64_t Hash = Map->HashState(HashLevel > 1 ? &ObjectHashes : nullptr);
+		Log << "Hash " << TimeSteps << " " << Map->Filename << " " << Map->GetObjectCount() << " " << Hash << std::endl;
+		if(HashLevel > 1) {
+			for(const auto &ObjectHash : ObjectHashes)
+				Log << "HashObject " << TimeSteps << " " << Map->Filename << " " << ObjectHash.NetworkID << " " << ObjectHash.Hash << " " << ObjectHash.Position.x << " " << ObjectHash.Position.y << std::endl;
+		}
+	}
 }
 
 // Handle client connect
 void _Server::HandleConnect(ae::_NetworkEvent &Event) {
 	//Log << TimeSteps << " -- connect peer_count=" << (int)Network->GetPeers().size() << std::endl;
+
+	// Send interned strings once per connection
+	ae::_Buffer Packet;
+	Packet.Write<char>(Packet::STRING_TABLE);
+	StringTable.Serialize(Packet);
+	Network->SendPacket(Packet, Event.Peer);
 }
 
 // Handle client disconnect
 void _Server::HandleDisconnect(ae::_NetworkEvent &Event) {
 
 	// Get object
-	_Object *Object = Event.Peer->Object;
+	if(!Event.Peer->Object)
+		return;
+
+	RemovePlayer(Event.Peer);
+
+	// Delete peer from network
+	Network->DeletePeer(Event.Peer);
+}
+
+// Remove a peer's player from its map
+void _Server::RemovePlayer(ae::_Peer *Peer) {
+
+	// Get object
+	_Object *Object = Peer->Object;
 	if(!Object)
 		return;
 
 	// Update map
 	_Map *Map = Object->Map;
 	if(Map) {
-		Map->RemovePeer(Event.Peer);
+		Map->RemovePeer(Peer);
 	}
 
 	// Remove from list
 	Object->Deleted = true;
-
-	// Delete peer from network
-	Network->DeletePeer(Event.Peer);
 }
 
 // Handle packet data
@@ -326,7 +487,7 @@ void _Server::HandleClientAttack(ae::_Buffer *Data, ae::_Peer *Peer) {
 	Stats->CreateObject(Object, "shot", true);
 	_Map *Map = Player->Map;
 
-	Object->Parent = Player;
+	Object->Parent = Player->Handle;
 	Object->Map = Map;
 	if(Object->HasComponent("shot")) {
 		_Shot *Shot = (_Shot *)(Object->Components["shot"]);
@@ -382,16 +543,19 @@ void _Server::ChangePlayerMap(const std::string &MapName, ae::_Peer *Peer) {
 
 	// Send object list to player
 	Map->AddPeer(Peer);
-	Map->SendObjectList(Object, TimeSteps);
+	auto StartTime = std::chrono::steady_clock::now();
+	size_t BytesSent = Map->SendObjectList(Object, TimeSteps);
+	double JoinTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+	Log << TimeSteps << " -- Sent object list map=" << Map->Filename << " objects=" << Map->GetObjectCount() << " bytes=" << BytesSent << " time=" << JoinTime << std::endl;
 }
 
-// Get a map if it's already loaded, if not load it and return it
+// Get a map if it's already loaded, if not load it and return it, returns null if loading fails
 _Map *_Server::GetMap(const std::string &MapName) {
 	std::string FixedMapName = _Map::FixFilename(MapName);
 
 	// Search for loaded map
 	for(auto &Map : MapManager->Objects) {
-		if(Map->Filename == FixedMapName) {
+		if(!Map->Deleted && Map->Filename == FixedMapName) {
 			return Map;
 		}
 	}
@@ -400,11 +564,24 @@ _Map *_Server::GetMap(const std::string &MapName) {
 	_Map *Map = nullptr;
 	try {
 		Map = MapManager->Create();
+		Map->StringTable = &StringTable;
 		Map->Load(MapName, Stats, ObjectManager, Network.get());
-		Map->Scripting->Server = this;
+		Map->Scripting->SetServer(this);
+		Map->PhysicsStep->WorkerPool = PhysicsWorkers.get();
+
+		// Wall-clock think budgets differ between runs, so hashed, recorded and replayed runs use a fixed count
+		if(Map->AiScheduler && (HashLevel || Journal || Replaying))
+			Map->AiScheduler->FixedAgentsPerTick = AI_FIXED_AGENTS_PER_TICK;
+		if(Journal)
+			Journal->WriteMap(MapName);
 	}
 	catch(std::exception &Error) {
 		Log << TimeSteps << " -- Error loading map: " << MapName << std::endl;
+
+		// Let the manager free the partially loaded map
+		if(Map)
+			Map->Deleted = true;
+		Map = nullptr;
 	}
 
 	return Map;
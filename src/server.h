@@ -19,6 +19,7 @@
 
 // Libraries
 #include <ae/log.h>
+#include <stringtable.h>
 #include <memory>
 #include <thread>
 #include <list>
@@ -27,10 +28,12 @@
 class _Object;
 class _Map;
 class _Stats;
+class _Journal;
+class _ServerTransport;
+class _WorkerPool;
 
 namespace ae {
 	template<class T> class _Manager;
-	class _ServerNetwork;
 	class _Buffer;
 	class _Peer;
 	struct _NetworkEvent;
@@ -42,6 +45,7 @@ class _Server {
 	public:
 
 		_Server(uint16_t NetworkPort);
+		_Server(_ServerTransport *Network);
 		~_Server();
 
 		void Update(double FrameTime);
@@ -49,6 +53,10 @@ class _Server {
 		void JoinThread();
 		void StopServer();
 
+		// Journal
+		bool StartRecording(const std::string &Path);
+		bool Replay(const std::string &Path);
+
 		_Map *GetMap(const std::string &MapName);
 		void ChangePlayerMap(const std::string &MapName, ae::_Peer *Peer);
 
@@ -58,22 +66,31 @@ class _Server {
 		bool StartShutdown;
 		uint16_t TimeSteps;
 		double Time;
+		int HashLevel;
+		bool Replaying;
 		ae::_LogFile Log;
 
 		// Stats
 		const _Stats *Stats;
+		_StringTable StringTable;
 
 		// Network
-		std::unique_ptr<ae::_ServerNetwork> Network;
+		std::unique_ptr<_ServerTransport> Network;
+		std::unique_ptr<_Journal> Journal;
 
 		// Objects
 		ae::_Manager<_Map> *MapManager;
 		ae::_Manager<_Object> *ObjectManager;
 
+		// Physics threads shared by all maps
+		std::unique_ptr<_WorkerPool> PhysicsWorkers;
+
 	private:
 
 		void HandleConnect(ae::_NetworkEvent &Event);
 		void HandleDisconnect(ae::_NetworkEvent &Event);
+		void RemovePlayer(ae::_Peer *Peer);
+		void LogStateHashes();
 		void HandlePacket(ae::_Buffer *Data, ae::_Peer *Peer);
 		void HandleClientJoin(ae::_Buffer *Data, ae::_Peer *Peer);
 		void HandleClientInput(ae::_Buffer *Data, ae::_Peer *Peer);
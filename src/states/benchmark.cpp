@@ -25,9 +25,27 @@
 #include <ae/font.h>
 #include <ae/program.h>
 #include <ae/light.h>
+#include <objects/object.h>
+#include <objects/physics.h>
+#include <objects/shape.h>
 #include <constants.h>
+#include <stats.h>
+#include <grid.h>
+#include <arena.h>
+#include <physicsstep.h>
+#include <workerpool.h>
+#include <stringtable.h>
+#include <floormesh.h>
+#include <renderbatch.h>
+#include <map.h>
+#include <ae/buffer.h>
 #include <iostream>
 #include <sstream>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <SDL_scancode.h>
@@ -37,7 +55,348 @@ static ae::_Camera *Camera;
 static const ae::_Font *Font;
 static const ae::_Texture *Texture;
 
+// Create objects at fixed random positions and velocities
+static void CreateBodies(_Grid &Grid, int Count, float BoxFraction, std::vector<_Object *> &Objects) {
+	_PhysicsStat PhysicsStat;
+	PhysicsStat.CollisionResponse = 1;
+
+	std::mt19937 Random(0);
+	std::uniform_real_distribution<float> PositionDistribution(1.0f, MAP_SIZE.x - 1.0f);
+	std::uniform_real_distribution<float> SizeDistribution(0.2f, 0.6f);
+	std::uniform_real_distribution<float> ShapeDistribution(0.0f, 1.0f);
+	std::uniform_real_distribution<float> VelocityDistribution(-0.5f, 0.5f);
+	for(int i = 0; i < Count; i++) {
+		_CollisionShapeStat ShapeStat;
+		float HalfWidth = SizeDistribution(Random);
+		if(ShapeDistribution(Random) < BoxFraction)
+			ShapeStat.HalfWidth = glm::vec3(HalfWidth, SizeDistribution(Random), 0.0f);
+		else
+			ShapeStat.HalfWidth = glm::vec3(HalfWidth, 0.0f, 0.0f);
+
+		_Object *Object = new _Object();
+		Object->NetworkID = (ae::NetworkIDType)i;
+		Object->Physics = new _Physics(Object, &PhysicsStat);
+		Object->Physics->Position = glm::vec3(PositionDistribution(Random), PositionDistribution(Random), 0.0f);
+		Object->Physics->Velocity = glm::vec3(VelocityDistribution(Random), VelocityDistribution(Random), 0.0f);
+		Object->Shape = new _CollisionShape(Object, &ShapeStat);
+		Object->Components["physics"] = Object->Physics;
+		Object->Components["shape"] = Object->Shape;
+		Grid.AddObject(Object);
+		Objects.push_back(Object);
+	}
+}
+
+// Time narrow phase queries for a mix of circles and boxes
+static void RunCollisionBenchmark(const std::string &Name, float BoxFraction) {
+	const int ObjectCount = 4000;
+	const int Iterations = 50;
+
+	_Grid Grid;
+	Grid.InitTiles();
+
+	std::vector<_Object *> Objects;
+	CreateBodies(Grid, ObjectCount, BoxFraction, Objects);
+
+	// Query every object against the grid
+	size_t PairCount = 0;
+	std::chrono::high_resolution_clock::time_point Start = std::chrono::high_resolution_clock::now();
+	for(int i = 0; i < Iterations; i++) {
+		for(auto &Object : Objects) {
+			_ArenaVector<_Push> Pushes(FrameArena);
+			bool AxisAlignedPush = false;
+			Grid.CheckCollisions(Object, glm::vec2(Object->Physics->Position), Pushes, AxisAlignedPush);
+			PairCount += Pushes.Size();
+		}
+
+		FrameArena.Reset();
+	}
+	double Time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - Start).count();
+
+	std::cout << "collision " << Name << ": pairs=" << PairCount / Iterations << " query_ns=" << Time * 1e9 / (ObjectCount * Iterations) << std::endl;
+
+	for(auto &Object : Objects)
+		delete Object;
+}
+
+// Step copies of a world sequentially and in two phases with one and several threads, returns false if any result differs
+static bool RunPhysicsBenchmark() {
+	const int ObjectCount = 4000;
+	const int Iterations = 100;
+	const int WorldCount = 3;
+	const int ThreadCount = std::max(4, (int)std::thread::hardware_concurrency());
+
+	// World 0 steps each body in list order like _Physics::Update, the others use the two phase step
+	_Map Maps[WorldCount];
+	std::vector<_Object *> Objects[WorldCount];
+	_PhysicsStep PhysicsSteps[WorldCount];
+	_WorkerPool WorkerPool(ThreadCount);
+	PhysicsSteps[2].WorkerPool = &WorkerPool;
+	double StepTime[WorldCount] = { 0.0, 0.0, 0.0 };
+	for(int i = 0; i < WorldCount; i++) {
+		Maps[i].Grid = new _Grid();
+		Maps[i].Grid->InitTiles();
+		CreateBodies(*Maps[i].Grid, ObjectCount, 0.5f, Objects[i]);
+		for(auto &Object : Objects[i]) {
+			Object->Map = &Maps[i];
+			PhysicsSteps[i].Bodies.push_back(Object->Physics);
+		}
+	}
+
+	// Every world must stay identical to the sequential one
+	int ThreadMismatches = 0;
+	int SequentialMismatches = 0;
+	size_t RedetectCount = 0;
+	for(int Tick = 0; Tick < Iterations; Tick++) {
+		for(int i = 0; i < WorldCount; i++) {
+			auto StartTime = std::chrono::steady_clock::now();
+			if(i == 0) {
+				for(auto &Object : Objects[i]) {
+					Object->Physics->Detect(Maps[i].Grid);
+					Object->Physics->Resolve();
+				}
+			}
+			else {
+				PhysicsSteps[i].Detect(Maps[i].Grid);
+				PhysicsSteps[i].Resolve(Maps[i].Grid);
+			}
+			StepTime[i] += std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+		}
+		RedetectCount += PhysicsSteps[2].RedetectCount;
+
+		for(size_t j = 0; j < Objects[1].size(); j++) {
+			_Physics *Sequential = Objects[0][j]->Physics;
+			_Physics *Serial = Objects[1][j]->Physics;
+			_Physics *Parallel = Objects[2][j]->Physics;
+			if(Serial->Position != Parallel->Position)
+				ThreadMismatches++;
+			if(Sequential->Position != Serial->Position)
+				SequentialMismatches++;
+		}
+	}
+
+	bool Deterministic = !ThreadMismatches && !SequentialMismatches;
+	std::cout << "physics sequential step_ms=" << StepTime[0] * 1000.0 / Iterations << std::endl;
+	std::cout << "physics two_phase threads=1 step_ms=" << StepTime[1] * 1000.0 / Iterations << std::endl;
+	std::cout << "physics two_phase threads=" << WorkerPool.GetThreadCount() << " step_ms=" << StepTime[2] * 1000.0 / Iterations << " redetects_per_tick=" << (double)RedetectCount / Iterations << std::endl;
+	std::cout << "physics deterministic=" << (Deterministic ? "yes" : "no") << " thread_mismatches=" << ThreadMismatches << " sequential_mismatches=" << SequentialMismatches << std::endl;
+
+	for(int i = 0; i < WorldCount; i++) {
+		for(auto &Object : Objects[i]) {
+			Object->Map = nullptr;
+			delete Object;
+		}
+	}
+
+	return Deterministic;
+}
+
+// Serialize a populated object list with literal and interned strings
+static void RunJoinBenchmark() {
+	const size_t ObjectCount = 2000;
+
+	_Stats Stats;
+	_StringTable StringTable;
+	StringTable.Build(&Stats);
+
+	std::vector<std::string> Identifiers;
+	for(const auto &ObjectStat : Stats.Objects)
+		Identifiers.push_back(ObjectStat.first);
+	std::sort(Identifiers.begin(), Identifiers.end());
+
+	// Create objects cycling through every stat
+	_Map Map;
+	std::vector<_Object *> Objects;
+	for(size_t i = 0; i < ObjectCount; i++) {
+		_Object *Object = new _Object();
+		Stats.CreateObject(Object, Identifiers[i % Identifiers.size()], true);
+		Object->NetworkID = (ae::NetworkIDType)i;
+		Object->Map = &Map;
+		Objects.push_back(Object);
+	}
+
+	// Build the chunks SendObjectList would send
+	const char *Names[2] = { "literal", "interned" };
+	for(int i = 0; i < 2; i++) {
+		Map.StringTable = i ? &StringTable : nullptr;
+
+		size_t Bytes = 0;
+		int Packets = 0;
+		auto StartTime = std::chrono::steady_clock::now();
+		for(size_t Start = 0; Start < Objects.size(); Start += NETWORK_OBJECT_LIST_CHUNK) {
+			ae::_Buffer Packet;
+			size_t End = std::min(Objects.size(), Start + NETWORK_OBJECT_LIST_CHUNK);
+			for(size_t j = Start; j < End; j++)
+				Objects[j]->NetworkSerialize(Packet);
+
+			Bytes += Packet.GetCurrentSize();
+			Packets++;
+		}
+		double Time = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+		std::cout << "join strings=" << Names[i] << " objects=" << ObjectCount << " packets=" << Packets << " bytes=" << Bytes << " serialize_ms=" << Time * 1000.0 << std::endl;
+	}
+
+	ae::_Buffer TablePacket;
+	StringTable.Serialize(TablePacket);
+	std::cout << "join string_table strings=" << StringTable.GetCount() << " bytes=" << TablePacket.GetCurrentSize() << std::endl;
+
+	for(auto &Object : Objects) {
+		Object->Map = nullptr;
+		delete Object;
+	}
+}
+
+// Build floor chunks and select them for a camera sweeping across a large map
+static void RunFloorBenchmark() {
+	const int Frames = 1000;
+	const glm::vec2 ViewSize(30.0f, 20.0f);
+
+	_Grid Grid;
+	Grid.Size = glm::ivec2(1024, 1024);
+	Grid.InitTiles();
+
+	std::mt19937 Random(0);
+	for(int j = 0; j < Grid.Size.y; j++) {
+		for(int i = 0; i < Grid.Size.x; i++)
+			Grid.Tiles[i][j].TextureIndex = Random() % 16;
+	}
+
+	// Split a 4x4 atlas without loading the texture
+	std::vector<glm::vec4> TextureCoords;
+	for(int j = 0; j < 4; j++) {
+		for(int i = 0; i < 4; i++)
+			TextureCoords.push_back(glm::vec4(i * 0.25f, j * 0.25f, (i + 1) * 0.25f, (j + 1) * 0.25f));
+	}
+	_FloorMesh FloorMesh(&Grid, TextureCoords);
+
+	// Build every chunk once
+	auto StartTime = std::chrono::steady_clock::now();
+	FloorMesh.SelectChunks(glm::vec4(0.0f, 0.0f, Grid.Size.x, Grid.Size.y));
+	FloorMesh.BuildChunks();
+	double BuildTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+	// Sweep the camera diagonally, editing a tile every few frames
+	int BuildCount = FloorMesh.GetBuildCount();
+	size_t VisibleChunkCount = 0;
+	StartTime = std::chrono::steady_clock::now();
+	for(int Frame = 0; Frame < Frames; Frame++) {
+		glm::vec2 Center(ViewSize + glm::vec2(Frame * 0.5f));
+		if(Frame % 10 == 0) {
+			glm::ivec2 Coord(Center);
+			Grid.Tiles[Coord.x][Coord.y].TextureIndex++;
+			FloorMesh.Invalidate(Coord);
+		}
+
+		FloorMesh.SelectChunks(glm::vec4(Center - ViewSize * 0.5f, Center + ViewSize * 0.5f));
+		FloorMesh.BuildChunks();
+		VisibleChunkCount += FloorMesh.GetVisibleChunkCount();
+	}
+	double FrameTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+	std::cout << "floor tiles=" << Grid.Size.x * Grid.Size.y << " chunks=" << FloorMesh.GetChunkCount() << " build_all_ms=" << BuildTime * 1000.0 << std::endl;
+	std::cout << "floor frames=" << Frames << " frame_us=" << FrameTime * 1000000.0 / Frames << " visible_chunks=" << (double)VisibleChunkCount / Frames << " rebuilt_chunks=" << FloorMesh.GetBuildCount() - BuildCount << std::endl;
+}
+
+// Build batches from shuffled draw items and check the command stream without drawing
+static void RunBatchBenchmark() {
+	const int ItemCount = 10000;
+	const int ProgramCount = 3;
+	const int TextureCount = 8;
+
+	// Only the addresses are compared, nothing is dereferenced
+	static char Programs[ProgramCount];
+	static char Textures[TextureCount];
+
+	std::mt19937 Random(0);
+	_RenderBatch Batch;
+	_RenderBatch OrderedBatch;
+	int UnbatchedProgramChanges = 0;
+	for(int i = 0; i < ItemCount; i++) {
+		_DrawItem Item;
+		Item.Type = _DrawItem::SPRITE;
+		Item.Program = (const ae::_Program *)&Programs[Random() % ProgramCount];
+		Item.Texture = (const ae::_Texture *)&Textures[Random() % TextureCount];
+		Item.Mesh = nullptr;
+		Item.Color = glm::vec4(1.0f);
+		Item.TextureCoords = glm::vec4(0.0f);
+		Item.Position = glm::vec3(i, 0.0f, 0.0f);
+		Item.Size = glm::vec3(1.0f);
+		Item.Rotation = 0.0f;
+
+		// Count program changes drawing the items in the order they were added
+		if(i == 0 || Item.Program != Batch.GetItems().back().Program)
+			UnbatchedProgramChanges++;
+
+		Batch.Add(Item);
+		OrderedBatch.Add(Item);
+	}
+
+	auto StartTime = std::chrono::steady_clock::now();
+	Batch.Build();
+	double Time = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+	// Batches must cover every item once, each state must appear in one batch, and equal items must stay in order
+	const auto &Items = Batch.GetItems();
+	const auto &Batches = Batch.GetBatches();
+	bool Valid = (int)Batches.size() <= ProgramCount * TextureCount;
+	size_t Next = 0;
+	for(const auto &DrawBatch : Batches) {
+		Valid &= DrawBatch.Start == Next;
+		for(size_t i = DrawBatch.Start; i < DrawBatch.Start + DrawBatch.Count; i++) {
+			Valid &= Items[i].Program == DrawBatch.Program && Items[i].Texture == DrawBatch.Texture;
+			if(i > DrawBatch.Start)
+				Valid &= Items[i].Position.x > Items[i - 1].Position.x;
+		}
+		Next += DrawBatch.Count;
+	}
+	Valid &= Next == Items.size() && Batch.GetQuadCount() == Items.size();
+
+	int ProgramChanges = 0;
+	for(size_t i = 0; i < Batches.size(); i++) {
+		if(i == 0 || Batches[i].Program != Batches[i - 1].Program)
+			ProgramChanges++;
+	}
+
+	// Layers without depth testing must keep their order
+	OrderedBatch.Build(false);
+	const auto &OrderedItems = OrderedBatch.GetItems();
+	bool OrderedValid = OrderedItems.size() == Items.size();
+	for(size_t i = 0; OrderedValid && i < OrderedItems.size(); i++)
+		OrderedValid = OrderedItems[i].Position.x == (float)i;
+
+	std::cout << "batch items=" << Items.size() << " batches=" << Batches.size() << " draw_calls=" << Batch.GetBatchDrawCalls() << " unbatched_draw_calls=" << ItemCount << " program_changes=" << ProgramChanges << " unbatched_program_changes=" << UnbatchedProgramChanges << " build_ms=" << Time * 1000.0 << " valid=" << (Valid ? "yes" : "no") << std::endl;
+	std::cout << "batch ordered batches=" << OrderedBatch.GetBatches().size() << " draw_calls=" << OrderedBatch.GetBatchDrawCalls() << " valid=" << (OrderedValid ? "yes" : "no") << std::endl;
+}
+
+// Benchmarks that print results and exit without a window
+bool _BenchmarkState::IsHeadless() const {
+	return Param1 == "collision" || Param1 == "physics" || Param1 == "join" || Param1 == "floor" || Param1 == "batch";
+}
+
 void _BenchmarkState::Init() {
+
+	// Run headless benchmarks
+	if(IsHeadless()) {
+		if(Param1 == "collision") {
+			RunCollisionBenchmark("circle", 0.0f);
+			RunCollisionBenchmark("aabb", 1.0f);
+			RunCollisionBenchmark("mixed", 0.5f);
+		}
+		else if(Param1 == "physics") {
+			if(!RunPhysicsBenchmark())
+				Framework.SetExitCode(1);
+		}
+		else if(Param1 == "join")
+			RunJoinBenchmark();
+		else if(Param1 == "floor")
+			RunFloorBenchmark();
+		else if(Param1 == "batch")
+			RunBatchBenchmark();
+
+		Framework.SetDone(true);
+		return;
+	}
+
 	SDL_GL_SetSwapInterval(1);
 
 	Camera = new ae::_Camera(glm::vec3(-2, -2, 7), 200, CAMERA_FOVY, CAMERA_NEAR, CAMERA_FAR);
@@ -36,6 +36,7 @@ class _BenchmarkState : public ae::_State {
 		void Render(double BlendFactor) override;
 
 		void SetParam1(const std::string &String) { Param1 = String; }
+		bool IsHeadless() const;
 
 	protected:
 
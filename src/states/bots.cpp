@@ -0,0 +1,120 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <states/bots.h>
+#include <framework.h>
+#include <bot.h>
+#include <stats.h>
+#include <constants.h>
+#include <iostream>
+#include <iomanip>
+
+_BotState BotState;
+
+// Constructor
+_BotState::_BotState() :
+	Stats(nullptr),
+	ConnectedCount(0),
+	HostAddress("127.0.0.1"),
+	MapName("test.map"),
+	NetworkPort(DEFAULT_NETWORKPORT),
+	BotCount(1),
+	AttackRate(BOT_ATTACK_RATE),
+	Duration(0.0),
+	Time(0.0),
+	ReportTimer(0.0) {
+
+}
+
+// Init
+void _BotState::Init() {
+	Stats = new _Stats();
+
+	for(int i = 0; i < BotCount; i++)
+		Bots.push_back(new _Bot(Stats, MapName, AttackRate, (uint32_t)i));
+
+	ConnectedCount = 0;
+	Time = 0.0;
+	ReportTimer = 0.0;
+
+	std::cout << "Starting " << BotCount << " bots against " << HostAddress << ":" << NetworkPort << std::endl;
+}
+
+// Close
+void _BotState::Close() {
+	for(auto &Bot : Bots) {
+		Bot->Disconnect();
+		delete Bot;
+	}
+	Bots.clear();
+
+	delete Stats;
+	Stats = nullptr;
+}
+
+// Update
+void _BotState::Update(double FrameTime) {
+
+	// Stagger connections so the server isn't hit by every join at once
+	for(int i = 0; i < BOT_CONNECTS_PER_UPDATE && ConnectedCount < Bots.size(); i++)
+		Bots[ConnectedCount++]->Connect(HostAddress, NetworkPort);
+
+	for(auto &Bot : Bots)
+		Bot->Update(FrameTime);
+
+	// Print stats
+	ReportTimer += FrameTime;
+	if(ReportTimer >= BOT_REPORT_PERIOD) {
+		Report();
+		ReportTimer = 0.0;
+	}
+
+	Time += FrameTime;
+	if(Duration > 0.0 && Time >= Duration)
+		Framework.SetDone(true);
+}
+
+// Print latency and bandwidth histograms for the last period
+void _BotState::Report() {
+	_Histogram Latency(BOT_LATENCY_BUCKET, BOT_LATENCY_BUCKETS);
+	_Histogram ReceiveSpeed(BOT_BANDWIDTH_BUCKET, BOT_BANDWIDTH_BUCKETS);
+	size_t TotalReceived = 0;
+	size_t TotalSent = 0;
+	uint32_t Snapshots = 0;
+	int Joined = 0;
+	for(auto &Bot : Bots) {
+		size_t Received = Bot->TakeReceivedBytes();
+		TotalReceived += Received;
+		TotalSent += Bot->TakeSentBytes();
+		Snapshots += Bot->Snapshots;
+		Latency.Merge(Bot->Latency);
+		Bot->Latency.Clear();
+		Bot->Snapshots = 0;
+
+		if(Bot->HasJoined()) {
+			ReceiveSpeed.Add(Received / ReportTimer / 1024.0);
+			Joined++;
+		}
+	}
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "time=" << Time << " bots=" << Bots.size() << " joined=" << Joined << " snapshots=" << Snapshots << std::endl;
+	std::cout << "  input_ack_ms p50=" << Latency.GetPercentile(50) << " p95=" << Latency.GetPercentile(95) << " p99=" << Latency.GetPercentile(99) << " max=" << Latency.GetMax() << " samples=" << Latency.GetCount() << std::endl;
+	std::cout << "  recv_kbs_per_bot p50=" << ReceiveSpeed.GetPercentile(50) << " p95=" << ReceiveSpeed.GetPercentile(95) << " max=" << ReceiveSpeed.GetMax() << std::endl;
+	std::cout << "  total_recv_kbs=" << TotalReceived / ReportTimer / 1024.0 << " total_sent_kbs=" << TotalSent / ReportTimer / 1024.0 << std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <ae/state.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Forward Declarations
+class _Bot;
+class _Stats;
+
+// Headless load generator running many bot clients in one process
+class _BotState : public ae::_State {
+
+	public:
+
+		_BotState();
+
+		// Setup
+		void Init() override;
+		void Close() override;
+
+		// Update
+		void Update(double FrameTime) override;
+
+		// State parameters
+		void SetBotCount(int BotCount) { this->BotCount = BotCount; }
+		void SetHostAddress(const std::string &HostAddress) { this->HostAddress = HostAddress; }
+		void SetNetworkPort(uint16_t NetworkPort) { this->NetworkPort = NetworkPort; }
+		void SetMapName(const std::string &MapName) { this->MapName = MapName; }
+		void SetAttackRate(double AttackRate) { this->AttackRate = AttackRate; }
+		void SetDuration(double Duration) { this->Duration = Duration; }
+
+	protected:
+
+		void Report();
+
+		const _Stats *Stats;
+		std::vector<_Bot *> Bots;
+		size_t ConnectedCount;
+
+		std::string HostAddress;
+		std::string MapName;
+		uint16_t NetworkPort;
+		int BotCount;
+		double AttackRate;
+		double Duration;
+		double Time;
+		double ReportTimer;
+
+};
+
+extern _BotState BotState;
@@ -18,7 +18,6 @@
 #include <states/client.h>
 #include <states/editor.h>
 #include <states/null.h>
-#include <ae/clientnetwork.h>
 #include <ae/manager.h>
 #include <objects/object.h>
 #include <objects/controller.h>
@@ -34,13 +33,16 @@
 #include <ae/assets.h>
 #include <hud.h>
 #include <map.h>
+#include <interpolator.h>
 #include <grid.h>
+#include <arena.h>
 #include <ae/audio.h>
 #include <config.h>
 #include <ae/actions.h>
 #include <ae/buffer.h>
 #include <ae/light.h>
 #include <server.h>
+#include <loopback.h>
 #include <packet.h>
 #include <stats.h>
 #include <actiontype.h>
@@ -77,8 +79,15 @@ void _ClientState::Init() {
 	Network = nullptr;
 	Server = nullptr;
 
+	// Talk to a local server in-process unless it should accept remote clients or lag is being simulated
+	_LoopbackServerTransport *Loopback = nullptr;
 	if(RunServer) {
-		Server = new _Server(ConnectPort);
+		if(Config.LocalLoopback && Config.FakeLag == 0.0) {
+			Loopback = new _LoopbackServerTransport();
+			Server = new _Server(Loopback);
+		}
+		else
+			Server = new _Server(ConnectPort);
 		Server->StartThread();
 	}
 
@@ -86,7 +95,10 @@ void _ClientState::Init() {
 
 	ObjectManager = new ae::_Manager<_Object>();
 
-	Network = new ae::_ClientNetwork();
+	if(Loopback)
+		Network = new _LoopbackClientTransport(Loopback);
+	else
+		Network = new _ENetClientTransport();
 	Network->SetFakeLag(Config.FakeLag);
 	Network->SetUpdatePeriod(Config.NetworkRate);
 	Network->Connect(HostAddress.c_str(), ConnectPort);
@@ -248,6 +260,9 @@ void _ClientState::Update(double FrameTime) {
 		Controller->HandleInput(Input);
 		Controller->History.PushBack(Input);
 		Player->Physics->Update(FrameTime);
+
+		// Remember the predicted position to check against the server
+		Controller->History.Back().Position = glm::vec2(Player->Physics->Position);
 	}
 
 	// TEMP
@@ -258,8 +273,11 @@ void _ClientState::Update(double FrameTime) {
 	ObjectManager->Update(FrameTime);
 
 	// Update map
-	if(Map)
+	if(Map) {
+		if(Map->Interpolator)
+			Map->Interpolator->SetRTT(Network->GetRTT());
 		Map->Update(FrameTime);
+	}
 
 	// Update camera
 	if(Camera && Player) {
@@ -290,6 +308,9 @@ void _ClientState::Update(double FrameTime) {
 
 	if(Player)
 		TimeSteps++;
+
+	// Free temporary allocations
+	FrameArena.Reset();
 }
 
 // Render the state
@@ -337,7 +358,7 @@ void _ClientState::Render(double BlendFactor) {
 
 		_ShotStat ShotStat;
 		_Object Object;
-		Object.Parent = Player;
+		Object.Parent = Player->Handle;
 		_Shot Shot(Player, &ShotStat);
 		Shot.Parent = &Object;
 		Shot.Position = glm::vec2(Player->Physics->Position);
@@ -410,6 +431,26 @@ void _ClientState::Render(double BlendFactor) {
 		Font->DrawText(Buffer.str(), glm::vec2(X+10, Y));
 		Buffer.str("");
 		Y += 15;
+
+		Buffer << Map->GetSkippedObjectCount();
+		Font->DrawText("Skipped", glm::vec2(X, Y), ae::RIGHT_BASELINE);
+		Font->DrawText(Buffer.str(), glm::vec2(X+10, Y));
+		Buffer.str("");
+		Y += 15;
+
+		if(Map->Interpolator) {
+			Buffer << Map->Interpolator->GetDelay();
+			Font->DrawText("Delay", glm::vec2(X, Y), ae::RIGHT_BASELINE);
+			Font->DrawText(Buffer.str(), glm::vec2(X+10, Y));
+			Buffer.str("");
+			Y += 15;
+		}
+
+		Buffer << Map->GetDrawCallCount();
+		Font->DrawText("Draws", glm::vec2(X, Y), ae::RIGHT_BASELINE);
+		Font->DrawText(Buffer.str(), glm::vec2(X+10, Y));
+		Buffer.str("");
+		Y += 15;
 	}
 	ae::Graphics.SetDepthMask(true);
 }
@@ -451,6 +492,9 @@ void _ClientState::HandlePacket(ae::_Buffer &Data) {
 		case Packet::UPDATE_HEALTH:
 			HandleUpdateHealth(Data);
 		break;
+		case Packet::STRING_TABLE:
+			HandleStringTable(Data);
+		break;
 	}
 }
 
@@ -487,25 +531,34 @@ void _ClientState::HandleMapInfo(ae::_Buffer &Data) {
 	delete Map;
 	Map = new _Map();
 	Map->NetworkID = MapID;
+	Map->StringTable = &StringTable;
 	Map->Load(NewMap, Stats, nullptr);
 	Map->SetCamera(Camera);
 	Player = nullptr;
 	Controller = nullptr;
 }
 
-// Handle a complete list of objects from a map
+// Handle a chunk of the list of objects from a map
 void _ClientState::HandleObjectList(ae::_Buffer &Data) {
-	ObjectManager->Clear();
-	Player = nullptr;
 
 	// Read header
-	TimeSteps = Data.Read<uint16_t>();
+	uint16_t ListTimeSteps = Data.Read<uint16_t>();
 	ae::NetworkIDType ClientNetworkID = Data.Read<ae::NetworkIDType>();
+	bool FirstChunk = Data.Read<char>();
 	ae::NetworkIDType ObjectCount = Data.Read<ae::NetworkIDType>();
 
+	// Start over on the first chunk
+	if(FirstChunk) {
+		ObjectManager->Clear();
+		Player = nullptr;
+		Controller = nullptr;
+		TimeSteps = ListTimeSteps;
+		LastServerTimeSteps = TimeSteps - 1;
+	}
+
 	// Read objects
 	for(ae::NetworkIDType i = 0; i < ObjectCount; i++) {
-		std::string Identifier = Data.ReadString();
+		std::string Identifier = _StringTable::ReadString(&StringTable, Data);
 		ae::NetworkIDType NetworkID = Data.Read<ae::NetworkIDType>();
 
 		// Create object
@@ -523,15 +576,14 @@ void _ClientState::HandleObjectList(ae::_Buffer &Data) {
 			Player = Object;
 	}
 
-	if(Player) {
+	// Set up player once its chunk arrives
+	if(Player && !Controller) {
 		Controller = (_Controller *)Player->Components["controller"];
 		Player->Log = Log;
 		Player->Physics->RenderDelay = false;
 		Player->Physics->UpdateAutomatically = false;
 		Camera->ForcePosition(glm::vec3(Player->Physics->Position.x, Player->Physics->Position.y, CAMERA_DISTANCE));
 	}
-
-	LastServerTimeSteps = TimeSteps - 1;
 }
 
 // Handle incremental updates from a map
@@ -547,6 +599,10 @@ void _ClientState::HandleObjectUpdates(ae::_Buffer &Data) {
 	if(!ae::_Network::MoreRecentAck(LastServerTimeSteps, ServerTimeSteps, uint16_t(-1)))
 		return;
 
+	// Measure snapshot jitter
+	if(Map->Interpolator)
+		Map->Interpolator->AddSnapshot(TimeSteps);
+
 	// Update objects
 	ae::NetworkIDType ObjectCount = Data.Read<ae::NetworkIDType>();
 	for(ae::NetworkIDType i = 0; i < ObjectCount; i++) {
@@ -575,7 +631,7 @@ void _ClientState::HandleObjectCreate(ae::_Buffer &Data) {
 		return;
 
 	// Get object properties
-	std::string Identifier = Data.ReadString();
+	std::string Identifier = _StringTable::ReadString(&StringTable, Data);
 	ae::NetworkIDType ID = Data.Read<ae::NetworkIDType>();
 
 	// Create object
@@ -620,3 +676,8 @@ void _ClientState::HandleUpdateHealth(ae::_Buffer &Data) {
 		std::cout << "Health update object_id=" << NetworkID << ", health=" << Health->Health << std::endl;
 	}
 }
+
+// Handle interned strings sent on connect
+void _ClientState::HandleStringTable(ae::_Buffer &Data) {
+	StringTable.Unserialize(Data);
+}
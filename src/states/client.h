@@ -19,6 +19,7 @@
 
 #include <ae/state.h>
 #include <ae/log.h>
+#include <stringtable.h>
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
 #include <list>
@@ -31,10 +32,10 @@ class _Controller;
 class _Item;
 class _Server;
 class _Stats;
+class _ClientTransport;
 
 namespace ae {
 	template<class T> class _Manager;
-	class _ClientNetwork;
 	class _Camera;
 	class _Font;
 	class _Buffer;
@@ -86,6 +87,7 @@ class _ClientState : public ae::_State {
 		void HandleObjectCreate(ae::_Buffer &Data);
 		void HandleObjectDelete(ae::_Buffer &Data);
 		void HandleUpdateHealth(ae::_Buffer &Data);
+		void HandleStringTable(ae::_Buffer &Data);
 
 		void SendAttack();
 		void SendUse();
@@ -120,7 +122,8 @@ class _ClientState : public ae::_State {
 		glm::vec2 WorldCursor;
 
 		// Network
-		ae::_ClientNetwork *Network;
+		_ClientTransport *Network;
+		_StringTable StringTable;
 		_Server *Server;
 		std::string HostAddress;
 		uint16_t TimeSteps;
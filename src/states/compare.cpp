@@ -0,0 +1,148 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <states/compare.h>
+#include <framework.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+_CompareState CompareState;
+
+// Checksum logged for one object
+struct _LoggedObject {
+	uint32_t NetworkID;
+	uint64_t Hash;
+	float X;
+	float Y;
+};
+
+// Checksum logged for one map on one tick
+struct _LoggedHash {
+	size_t Line;
+	uint32_t TimeSteps;
+	std::string Map;
+	size_t ObjectCount;
+	uint64_t Hash;
+	std::vector<_LoggedObject> Objects;
+};
+
+// Read hash lines from a server log, object lines belong to the map line before them
+static bool ReadHashes(const std::string &Path, std::vector<_LoggedHash> &Hashes) {
+	std::ifstream File(Path);
+	if(!File)
+		return false;
+
+	std::string Line;
+	size_t LineNumber = 0;
+	while(std::getline(File, Line)) {
+		LineNumber++;
+		size_t Start = Line.find("Hash");
+		if(Start == std::string::npos)
+			continue;
+
+		std::istringstream Stream(Line.substr(Start));
+		std::string Type;
+		Stream >> Type;
+		if(Type == "Hash") {
+			_LoggedHash Hash;
+			Hash.Line = LineNumber;
+			if(Stream >> Hash.TimeSteps >> Hash.Map >> Hash.ObjectCount >> Hash.Hash)
+				Hashes.push_back(Hash);
+		}
+		else if(Type == "HashObject" && !Hashes.empty()) {
+			uint32_t TimeSteps;
+			std::string Map;
+			_LoggedObject Object;
+			if(Stream >> TimeSteps >> Map >> Object.NetworkID >> Object.Hash >> Object.X >> Object.Y)
+				Hashes.back().Objects.push_back(Object);
+		}
+	}
+
+	return true;
+}
+
+// Report the first object that differs between two logged ticks, objects are logged in network id order
+static void CompareObjects(const _LoggedHash &A, const _LoggedHash &B) {
+	if(A.Objects.empty() || B.Objects.empty()) {
+		std::cout << "no object checksums logged, run with -hash 2 to find the divergent object" << std::endl;
+		return;
+	}
+
+	size_t IndexA = 0;
+	size_t IndexB = 0;
+	while(IndexA < A.Objects.size() || IndexB < B.Objects.size()) {
+		const _LoggedObject *ObjectA = IndexA < A.Objects.size() ? &A.Objects[IndexA] : nullptr;
+		const _LoggedObject *ObjectB = IndexB < B.Objects.size() ? &B.Objects[IndexB] : nullptr;
+		if(ObjectA && (!ObjectB || ObjectA->NetworkID < ObjectB->NetworkID)) {
+			std::cout << "object " << ObjectA->NetworkID << " only exists in the first run at " << ObjectA->X << ", " << ObjectA->Y << std::endl;
+			return;
+		}
+		if(ObjectB && (!ObjectA || ObjectB->NetworkID < ObjectA->NetworkID)) {
+			std::cout << "object " << ObjectB->NetworkID << " only exists in the second run at " << ObjectB->X << ", " << ObjectB->Y << std::endl;
+			return;
+		}
+		if(ObjectA->Hash != ObjectB->Hash) {
+			std::cout << "object " << ObjectA->NetworkID << " differs: " << ObjectA->X << ", " << ObjectA->Y << " vs " << ObjectB->X << ", " << ObjectB->Y << std::endl;
+			return;
+		}
+
+		IndexA++;
+		IndexB++;
+	}
+}
+
+// Init
+void _CompareState::Init() {
+	std::vector<_LoggedHash> HashesA;
+	std::vector<_LoggedHash> HashesB;
+	if(!ReadHashes(PathA, HashesA) || !ReadHashes(PathB, HashesB)) {
+		std::cerr << "Unable to read " << PathA << " or " << PathB << std::endl;
+		Framework.SetDone(true);
+		return;
+	}
+
+	// Find the first map checksum that differs
+	size_t Count = std::min(HashesA.size(), HashesB.size());
+	for(size_t i = 0; i < Count; i++) {
+		const _LoggedHash &A = HashesA[i];
+		const _LoggedHash &B = HashesB[i];
+		if(A.Map == B.Map && A.TimeSteps == B.TimeSteps && A.Hash == B.Hash)
+			continue;
+
+		std::cout << "diverged at checksum " << i << ": timesteps=" << A.TimeSteps << " map=" << A.Map << " objects=" << A.ObjectCount << " (line " << A.Line << ")";
+		std::cout << " vs timesteps=" << B.TimeSteps << " map=" << B.Map << " objects=" << B.ObjectCount << " (line " << B.Line << ")" << std::endl;
+		if(A.Map == B.Map)
+			CompareObjects(A, B);
+
+		Framework.SetDone(true);
+		return;
+	}
+
+	if(HashesA.size() != HashesB.size())
+		std::cout << "first " << Count << " checksums match, " << PathA << " has " << HashesA.size() << " and " << PathB << " has " << HashesB.size() << std::endl;
+	else
+		std::cout << "all " << Count << " checksums match" << std::endl;
+
+	Framework.SetDone(true);
+}
+
+// Close
+void _CompareState::Close() {
+}
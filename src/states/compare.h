@@ -0,0 +1,40 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+#include <ae/state.h>
+#include <string>
+
+// Compare the state checksums logged by two server runs
+class _CompareState : public ae::_State {
+
+	public:
+
+		// Setup
+		void Init() override;
+		void Close() override;
+
+		void SetPaths(const std::string &PathA, const std::string &PathB) { this->PathA = PathA; this->PathB = PathB; }
+
+	protected:
+
+		std::string PathA;
+		std::string PathB;
+};
+
+extern _CompareState CompareState;
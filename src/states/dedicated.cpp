@@ -18,6 +18,7 @@
 #include <states/dedicated.h>
 #include <framework.h>
 #include <server.h>
+#include <loopback.h>
 
 _DedicatedState DedicatedState;
 
@@ -41,16 +42,38 @@ void RunCommandThread(_Server *Server) {
 // Constructor
 _DedicatedState::_DedicatedState() :
 	Server(nullptr),
-	Thread(nullptr) {
+	Thread(nullptr),
+	NetworkPort(0),
+	HashLevel(0) {
 
 }
 
 // Init
 void _DedicatedState::Init() {
 
+	// Replay a journal without opening a socket
+	if(!ReplayPath.empty()) {
+		try {
+			Server = new _Server(new _LoopbackServerTransport());
+			Server->Log.SetToStdOut(true);
+			Server->HashLevel = HashLevel;
+			if(!Server->Replay(ReplayPath))
+				std::cerr << "Unable to read journal " << ReplayPath << std::endl;
+		}
+		catch(std::exception &Error) {
+			std::cerr << Error.what() << std::endl;
+		}
+
+		Framework.SetDone(true);
+		return;
+	}
+
 	// Setup server
 	try {
 		Server = new _Server(NetworkPort);
+		Server->HashLevel = HashLevel;
+		if(!RecordPath.empty() && !Server->StartRecording(RecordPath))
+			std::cerr << "Unable to open journal " << RecordPath << std::endl;
 
 		std::cout << "Listening on port " << NetworkPort << std::endl;
 
@@ -74,6 +97,9 @@ void _DedicatedState::Close() {
 
 // Update
 void _DedicatedState::Update(double FrameTime) {
+	if(!Server)
+		return;
+
 	Server->Update(FrameTime);
 
 	if(Server->Done) {
@@ -41,6 +41,9 @@ class _DedicatedState : public ae::_State {
 
 		// State parameters
 		void SetNetworkPort(uint16_t NetworkPort) { this->NetworkPort = NetworkPort; }
+		void SetRecordPath(const std::string &RecordPath) { this->RecordPath = RecordPath; }
+		void SetReplayPath(const std::string &ReplayPath) { this->ReplayPath = ReplayPath; }
+		void SetHashLevel(int HashLevel) { this->HashLevel = HashLevel; }
 
 	protected:
 
@@ -48,7 +51,10 @@ class _DedicatedState : public ae::_State {
 		std::thread *Thread;
 
 		std::string HostAddress;
+		std::string RecordPath;
+		std::string ReplayPath;
 		uint16_t NetworkPort;
+		int HashLevel;
 
 };
 
@@ -32,6 +32,7 @@
 #include <ae/assets.h>
 #include <map.h>
 #include <grid.h>
+#include <arena.h>
 #include <menu.h>
 #include <ae/texture.h>
 #include <ae/atlas.h>
@@ -552,7 +553,7 @@ void _EditorState::HandleMouseButton(const ae::_MouseEvent &MouseEvent) {
 					AABB[2] = std::max(ClickedPosition.x, WorldCursor.x) - MAP_BLOCK_ADJUST;
 					AABB[3] = std::max(ClickedPosition.y, WorldCursor.y) - MAP_BLOCK_ADJUST;
 
-					std::list<_Object *> Selection;
+					_ArenaVector<_Object *> Selection(FrameArena);
 					Map->GetSelectedObjects(AABB, Selection);
 
 					// Filter selection by palette type
@@ -663,7 +664,7 @@ void _EditorState::Update(double FrameTime) {
 								continue;
 
 							glm::ivec2 TilePosition = Map->Grid->GetValidCoord(WorldCursor + glm::vec2(Offset));
-							Map->Grid->Tiles[TilePosition.x][TilePosition.y].TextureIndex = Brush[EDITMODE_TILES]->TextureIndex;
+							Map->SetTileTexture(TilePosition, Brush[EDITMODE_TILES]->TextureIndex);
 						}
 					}
 				}
@@ -709,9 +710,15 @@ void _EditorState::Update(double FrameTime) {
 			if(!Object->Physics)
 				continue;
 
-			Object->Physics->Position = glm::vec3(Map->GetValidPosition(glm::vec2(Object->Physics->NetworkPosition) + WorldCursor - ClickedPosition), Object->Physics->Position.z);
+			// Rebucket so rendering through the grid can still find the object
+			Map->Grid->RemoveObject(Object);
+			Object->Physics->LastPosition = Object->Physics->Position = glm::vec3(Map->GetValidPosition(glm::vec2(Object->Physics->NetworkPosition) + WorldCursor - ClickedPosition), Object->Physics->Position.z);
+			Map->Grid->AddObject(Object);
 		}
 	}
+
+	// Free temporary allocations
+	FrameArena.Reset();
 }
 
 // Render the state
@@ -1323,7 +1330,9 @@ void _EditorState::ConfirmMove() {
 // Cancel a move operation
 void _EditorState::CancelMove() {
 	for(auto &Object : SelectedObjects) {
-		Object->Physics->Position = Object->Physics->NetworkPosition;
+		Map->Grid->RemoveObject(Object);
+		Object->Physics->LastPosition = Object->Physics->Position = Object->Physics->NetworkPosition;
+		Map->Grid->AddObject(Object);
 	}
 
 	IsMoving = false;
@@ -173,6 +173,10 @@ void _Stats::CreateObject(_Object *Object, const std::string Identifier, bool Is
 		}
 	}
 
+	// Objects without behavior never change after being placed
+	if(Object->Lifetime < 0.0f && !Object->Animation && !Object->HasComponent("controller") && !Object->HasComponent("shot") && !Object->HasComponent("health") && !Object->HasComponent("ai"))
+		Object->SetActivity(_Object::STATIC);
+
 	return;
 }
 
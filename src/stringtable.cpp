@@ -0,0 +1,124 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <stringtable.h>
+#include <stats.h>
+#include <ae/buffer.h>
+#include <algorithm>
+
+// Remove all strings
+void _StringTable::Clear() {
+	Strings.clear();
+	IDs.clear();
+}
+
+// Add a string and return its id
+uint32_t _StringTable::Add(const std::string &String) {
+	auto Iterator = IDs.find(String);
+	if(Iterator != IDs.end())
+		return Iterator->second;
+
+	uint32_t ID = (uint32_t)Strings.size();
+	Strings.push_back(String);
+	IDs[String] = ID;
+
+	return ID;
+}
+
+// Add object identifiers and texture names from stats in a stable order
+void _StringTable::Build(const _Stats *Stats) {
+	std::vector<std::string> Names;
+	for(const auto &ObjectStat : Stats->Objects) {
+		Names.push_back(ObjectStat.second.Identifier);
+
+		auto Iterator = ObjectStat.second.Components.find("render");
+		if(Iterator != ObjectStat.second.Components.end()) {
+			const _RenderStat *RenderStat = (const _RenderStat *)Iterator->second.get();
+			if(!RenderStat->TextureIdentifier.empty())
+				Names.push_back(RenderStat->TextureIdentifier);
+		}
+	}
+
+	std::sort(Names.begin(), Names.end());
+	for(const auto &Name : Names)
+		Add(Name);
+}
+
+// Serialize
+void _StringTable::Serialize(ae::_Buffer &Buffer) const {
+	WriteVarint(Buffer, (uint32_t)Strings.size());
+	for(const auto &String : Strings)
+		Buffer.WriteString(String.c_str());
+}
+
+// Unserialize
+void _StringTable::Unserialize(ae::_Buffer &Buffer) {
+	Clear();
+
+	uint32_t Count = ReadVarint(Buffer);
+	for(uint32_t i = 0; i < Count; i++)
+		Add(Buffer.ReadString());
+}
+
+// Write id + 1 for known strings, or zero followed by the string
+void _StringTable::WriteString(const _StringTable *Table, ae::_Buffer &Buffer, const std::string &String) {
+	if(Table) {
+		auto Iterator = Table->IDs.find(String);
+		if(Iterator != Table->IDs.end()) {
+			WriteVarint(Buffer, Iterator->second + 1);
+			return;
+		}
+	}
+
+	WriteVarint(Buffer, 0);
+	Buffer.WriteString(String.c_str());
+}
+
+// Read a string written with WriteString
+std::string _StringTable::ReadString(const _StringTable *Table, ae::_Buffer &Buffer) {
+	uint32_t ID = ReadVarint(Buffer);
+	if(ID == 0)
+		return Buffer.ReadString();
+
+	if(!Table || ID > Table->Strings.size())
+		return "";
+
+	return Table->Strings[ID - 1];
+}
+
+// Write 7 bits at a time, high bit set while more bytes follow
+void _StringTable::WriteVarint(ae::_Buffer &Buffer, uint32_t Value) {
+	while(Value >= 0x80) {
+		Buffer.Write<uint8_t>((uint8_t)(Value | 0x80));
+		Value >>= 7;
+	}
+
+	Buffer.Write<uint8_t>((uint8_t)Value);
+}
+
+// Read a varint
+uint32_t _StringTable::ReadVarint(ae::_Buffer &Buffer) {
+	uint32_t Value = 0;
+	for(int Shift = 0; Shift < 35; Shift += 7) {
+		uint8_t Byte = Buffer.Read<uint8_t>();
+		Value |= (uint32_t)(Byte & 0x7f) << Shift;
+		if(!(Byte & 0x80))
+			break;
+	}
+
+	return Value;
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Forward Declarations
+class _Stats;
+
+namespace ae {
+	class _Buffer;
+}
+
+// Strings sent once per connection so packets can refer to them by varint id
+class _StringTable {
+
+	public:
+
+		void Clear();
+		uint32_t Add(const std::string &String);
+		void Build(const _Stats *Stats);
+		size_t GetCount() const { return Strings.size(); }
+
+		// Network
+		void Serialize(ae::_Buffer &Buffer) const;
+		void Unserialize(ae::_Buffer &Buffer);
+
+		// Strings missing from the table, or written without a table, are sent literally
+		static void WriteString(const _StringTable *Table, ae::_Buffer &Buffer, const std::string &String);
+		static std::string ReadString(const _StringTable *Table, ae::_Buffer &Buffer);
+		static void WriteVarint(ae::_Buffer &Buffer, uint32_t Value);
+		static uint32_t ReadVarint(ae::_Buffer &Buffer);
+
+	private:
+
+		std::vector<std::string> Strings;
+		std::unordered_map<std::string, uint32_t> IDs;
+
+};
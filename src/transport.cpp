@@ -0,0 +1,185 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <transport.h>
+#include <ae/servernetwork.h>
+#include <ae/clientnetwork.h>
+#include <ae/buffer.h>
+#include <ae/peer.h>
+#include <enet/enet.h>
+#include <stdexcept>
+
+// Constructor
+_ENetServerTransport::_ENetServerTransport(size_t MaxPeers, uint16_t NetworkPort) :
+	Network(new ae::_ServerNetwork(MaxPeers, NetworkPort)),
+	FakeLag(0.0),
+	SpeedTimer(0.0),
+	BroadcastBytes(0),
+	BroadcastSpeed(0.0f) {
+
+	if(!Network->HasConnection())
+		throw std::runtime_error("Unable to bind address!");
+}
+
+// Destructor
+_ENetServerTransport::~_ENetServerTransport() {
+}
+
+void _ENetServerTransport::Update(double FrameTime) {
+	Network->Update(FrameTime);
+
+	// Update broadcast speed once a second
+	SpeedTimer += FrameTime;
+	if(SpeedTimer >= 1.0) {
+		BroadcastSpeed = (float)(BroadcastBytes / SpeedTimer);
+		BroadcastBytes = 0;
+		SpeedTimer = 0.0;
+	}
+}
+
+bool _ENetServerTransport::GetNetworkEvent(ae::_NetworkEvent &Event) {
+	return Network->GetNetworkEvent(Event);
+}
+
+bool _ENetServerTransport::NeedsUpdate() {
+	return Network->NeedsUpdate();
+}
+
+void _ENetServerTransport::ResetUpdateTimer() {
+	Network->ResetUpdateTimer();
+}
+
+void _ENetServerTransport::SetFakeLag(double Value) {
+	FakeLag = Value;
+	Network->SetFakeLag(Value);
+}
+
+void _ENetServerTransport::SetUpdatePeriod(double Value) {
+	Network->SetUpdatePeriod(Value);
+}
+
+// Send a packet to a peer, journal peers have no connection so their packets are dropped
+void _ENetServerTransport::SendPacket(ae::_Buffer &Buffer, const ae::_Peer *Peer, ae::_Network::SendType Type, uint8_t Channel) {
+	if(!Peer->ENetPeer)
+		return;
+
+	Network->SendPacket(Buffer, Peer, Type, Channel);
+}
+
+// Send one reference counted ENet packet to every peer instead of a copy each
+void _ENetServerTransport::BroadcastPacket(ae::_Buffer &Buffer, const std::vector<const ae::_Peer *> &Peers, ae::_Network::SendType Type, uint8_t Channel) {
+	if(Peers.empty())
+		return;
+
+	// Fake lag queues packets inside the network layer, so send through it per peer
+	if(FakeLag > 0.0) {
+		for(auto &Peer : Peers)
+			SendPacket(Buffer, Peer, Type, Channel);
+
+		return;
+	}
+
+	enet_uint32 Flags = 0;
+	if(Type == ae::_Network::RELIABLE)
+		Flags = ENET_PACKET_FLAG_RELIABLE;
+	else if(Type == ae::_Network::UNSEQUENCED)
+		Flags = ENET_PACKET_FLAG_UNSEQUENCED;
+
+	ENetPacket *Packet = enet_packet_create(Buffer.GetData(), Buffer.GetCurrentSize(), Flags);
+	for(auto &Peer : Peers) {
+		if(Peer->ENetPeer && enet_peer_send((ENetPeer *)Peer->ENetPeer, Channel, Packet) == 0)
+			BroadcastBytes += Buffer.GetCurrentSize();
+	}
+
+	// ENet frees the packet after the last peer sends it, unless no peer took it
+	if(Packet->referenceCount == 0)
+		enet_packet_destroy(Packet);
+}
+
+const std::list<ae::_Peer *> &_ENetServerTransport::GetPeers() {
+	return Network->GetPeers();
+}
+
+void _ENetServerTransport::DisconnectAll() {
+	Network->DisconnectAll();
+}
+
+void _ENetServerTransport::DeletePeer(ae::_Peer *Peer) {
+	Network->DeletePeer(Peer);
+}
+
+// Get bytes sent per second, including shared broadcast packets
+float _ENetServerTransport::GetSentSpeed() {
+	return Network->GetSentSpeed() + BroadcastSpeed;
+}
+
+// Constructor
+_ENetClientTransport::_ENetClientTransport() :
+	Network(new ae::_ClientNetwork()) {
+}
+
+// Destructor
+_ENetClientTransport::~_ENetClientTransport() {
+}
+
+void _ENetClientTransport::Update(double FrameTime) {
+	Network->Update(FrameTime);
+}
+
+bool _ENetClientTransport::GetNetworkEvent(ae::_NetworkEvent &Event) {
+	return Network->GetNetworkEvent(Event);
+}
+
+void _ENetClientTransport::ResetUpdateTimer() {
+	Network->ResetUpdateTimer();
+}
+
+void _ENetClientTransport::SetFakeLag(double Value) {
+	Network->SetFakeLag(Value);
+}
+
+void _ENetClientTransport::SetUpdatePeriod(double Value) {
+	Network->SetUpdatePeriod(Value);
+}
+
+void _ENetClientTransport::Connect(const char *HostAddress, uint16_t Port) {
+	Network->Connect(HostAddress, Port);
+}
+
+void _ENetClientTransport::Disconnect(bool Force) {
+	Network->Disconnect(Force);
+}
+
+bool _ENetClientTransport::IsConnected() {
+	return Network->IsConnected();
+}
+
+void _ENetClientTransport::SendPacket(ae::_Buffer &Buffer, ae::_Network::SendType Type, uint8_t Channel) {
+	Network->SendPacket(Buffer, Type, Channel);
+}
+
+float _ENetClientTransport::GetSentSpeed() {
+	return Network->GetSentSpeed();
+}
+
+float _ENetClientTransport::GetReceiveSpeed() {
+	return Network->GetReceiveSpeed();
+}
+
+uint32_t _ENetClientTransport::GetRTT() {
+	return Network->GetRTT();
+}
@@ -0,0 +1,145 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <ae/network.h>
+#include <list>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Forward Declarations
+namespace ae {
+	class _ServerNetwork;
+	class _ClientNetwork;
+	class _Buffer;
+	class _Peer;
+}
+
+// Server side of the network, implemented over ENet or an in-process loopback
+class _ServerTransport {
+
+	public:
+
+		virtual ~_ServerTransport() { }
+
+		virtual void Update(double FrameTime) = 0;
+		virtual bool GetNetworkEvent(ae::_NetworkEvent &Event) = 0;
+		virtual bool NeedsUpdate() = 0;
+		virtual void ResetUpdateTimer() = 0;
+		virtual void SetFakeLag(double Value) = 0;
+		virtual void SetUpdatePeriod(double Value) = 0;
+
+		virtual void SendPacket(ae::_Buffer &Buffer, const ae::_Peer *Peer, ae::_Network::SendType Type=ae::_Network::RELIABLE, uint8_t Channel=0) = 0;
+		virtual void BroadcastPacket(ae::_Buffer &Buffer, const std::vector<const ae::_Peer *> &Peers, ae::_Network::SendType Type=ae::_Network::RELIABLE, uint8_t Channel=0) = 0;
+		virtual const std::list<ae::_Peer *> &GetPeers() = 0;
+		virtual void DisconnectAll() = 0;
+		virtual void DeletePeer(ae::_Peer *Peer) = 0;
+
+		virtual float GetSentSpeed() = 0;
+
+};
+
+// Client side of the network
+class _ClientTransport {
+
+	public:
+
+		virtual ~_ClientTransport() { }
+
+		virtual void Update(double FrameTime) = 0;
+		virtual bool GetNetworkEvent(ae::_NetworkEvent &Event) = 0;
+		virtual void ResetUpdateTimer() = 0;
+		virtual void SetFakeLag(double Value) = 0;
+		virtual void SetUpdatePeriod(double Value) = 0;
+
+		virtual void Connect(const char *HostAddress, uint16_t Port) = 0;
+		virtual void Disconnect(bool Force=false) = 0;
+		virtual bool IsConnected() = 0;
+		virtual void SendPacket(ae::_Buffer &Buffer, ae::_Network::SendType Type=ae::_Network::RELIABLE, uint8_t Channel=0) = 0;
+
+		virtual float GetSentSpeed() = 0;
+		virtual float GetReceiveSpeed() = 0;
+		virtual uint32_t GetRTT() = 0;
+
+};
+
+// Server over ENet UDP sockets
+class _ENetServerTransport : public _ServerTransport {
+
+	public:
+
+		_ENetServerTransport(size_t MaxPeers, uint16_t NetworkPort);
+		~_ENetServerTransport() override;
+
+		void Update(double FrameTime) override;
+		bool GetNetworkEvent(ae::_NetworkEvent &Event) override;
+		bool NeedsUpdate() override;
+		void ResetUpdateTimer() override;
+		void SetFakeLag(double Value) override;
+		void SetUpdatePeriod(double Value) override;
+
+		void SendPacket(ae::_Buffer &Buffer, const ae::_Peer *Peer, ae::_Network::SendType Type=ae::_Network::RELIABLE, uint8_t Channel=0) override;
+		void BroadcastPacket(ae::_Buffer &Buffer, const std::vector<const ae::_Peer *> &Peers, ae::_Network::SendType Type=ae::_Network::RELIABLE, uint8_t Channel=0) override;
+		const std::list<ae::_Peer *> &GetPeers() override;
+		void DisconnectAll() override;
+		void DeletePeer(ae::_Peer *Peer) override;
+
+		float GetSentSpeed() override;
+
+	private:
+
+		std::unique_ptr<ae::_ServerNetwork> Network;
+		double FakeLag;
+
+		// Shared broadcast packets bypass the network's own counters
+		double SpeedTimer;
+		size_t BroadcastBytes;
+		float BroadcastSpeed;
+
+};
+
+// Client over ENet UDP sockets
+class _ENetClientTransport : public _ClientTransport {
+
+	public:
+
+		_ENetClientTransport();
+		~_ENetClientTransport() override;
+
+		void Update(double FrameTime) override;
+		bool GetNetworkEvent(ae::_NetworkEvent &Event) override;
+		void ResetUpdateTimer() override;
+		void SetFakeLag(double Value) override;
+		void SetUpdatePeriod(double Value) override;
+
+		void Connect(const char *HostAddress, uint16_t Port) override;
+		void Disconnect(bool Force=false) override;
+		bool IsConnected() override;
+		void SendPacket(ae::_Buffer &Buffer, ae::_Network::SendType Type=ae::_Network::RELIABLE, uint8_t Channel=0) override;
+
+		float GetSentSpeed() override;
+		float GetReceiveSpeed() override;
+		uint32_t GetRTT() override;
+
+	private:
+
+		std::unique_ptr<ae::_ClientNetwork> Network;
+
+};
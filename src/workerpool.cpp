@@ -0,0 +1,109 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#include <workerpool.h>
+#include <arena.h>
+
+// Constructor, the caller counts as one of the threads
+_WorkerPool::_WorkerPool(int ThreadCount) :
+	Job(nullptr),
+	JobCount(0),
+	NextJob(0),
+	BusyThreads(0),
+	Batch(0),
+	Done(false) {
+
+	for(int i = 1; i < ThreadCount; i++)
+		Threads.push_back(std::thread(&_WorkerPool::Work, this));
+}
+
+// Destructor
+_WorkerPool::~_WorkerPool() {
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Done = true;
+	}
+	StartCondition.notify_all();
+
+	for(auto &Thread : Threads)
+		Thread.join();
+}
+
+// Run jobs 0 to JobCount - 1 and wait for all of them to finish
+void _WorkerPool::Run(size_t JobCount, const std::function<void(size_t)> &Job) {
+	if(Threads.empty()) {
+		for(size_t i = 0; i < JobCount; i++)
+			Job(i);
+
+		return;
+	}
+
+	// Publish batch
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		this->Job = &Job;
+		this->JobCount = JobCount;
+		NextJob = 0;
+		BusyThreads = Threads.size();
+		Batch++;
+	}
+	StartCondition.notify_all();
+
+	RunJobs();
+
+	// Wait for workers
+	std::unique_lock<std::mutex> Lock(Mutex);
+	DoneCondition.wait(Lock, [this]() { return BusyThreads == 0; });
+	this->Job = nullptr;
+}
+
+// Worker thread loop
+void _WorkerPool::Work() {
+	uint64_t LastBatch = 0;
+	while(true) {
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			StartCondition.wait(Lock, [this, LastBatch]() { return Done || Batch != LastBatch; });
+			if(Done)
+				return;
+
+			LastBatch = Batch;
+		}
+
+		RunJobs();
+
+		// Worker arenas only hold data for the batch
+		FrameArena.Reset();
+
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			BusyThreads--;
+		}
+		DoneCondition.notify_one();
+	}
+}
+
+// Take jobs until the batch is empty
+void _WorkerPool::RunJobs() {
+	while(true) {
+		size_t Index = NextJob++;
+		if(Index >= JobCount)
+			return;
+
+		(*Job)(Index);
+	}
+}
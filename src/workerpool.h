@@ -0,0 +1,59 @@
+/******************************************************************************
+* esdf
+* Copyright (C) 2017  Alan Witkowski
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*******************************************************************************/
+#pragma once
+
+// Libraries
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Persistent threads that run batches of jobs, the calling thread takes jobs too
+class _WorkerPool {
+
+	public:
+
+		_WorkerPool(int ThreadCount);
+		~_WorkerPool();
+
+		void Run(size_t JobCount, const std::function<void(size_t)> &Job);
+		int GetThreadCount() const { return (int)Threads.size() + 1; }
+
+	private:
+
+		void Work();
+		void RunJobs();
+
+		std::vector<std::thread> Threads;
+
+		// Current batch
+		std::mutex Mutex;
+		std::condition_variable StartCondition;
+		std::condition_variable DoneCondition;
+		const std::function<void(size_t)> *Job;
+		size_t JobCount;
+		std::atomic<size_t> NextJob;
+		size_t BusyThreads;
+		uint64_t Batch;
+		bool Done;
+
+};